@@ -10,7 +10,26 @@
 #include "TopDownGameplayTags.h"
 #include "AbilitySystem/BaseAbilitySystemComponent.h"
 #include "AbilitySystem/BaseAttributeSet.h"
+#include "Subsystem/TopDownProjectilePoolSubsystem.h"
 
+void UTopDownProjectileAbility::OnGiveAbility(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec)
+{
+	Super::OnGiveAbility(ActorInfo, Spec);
+
+	const AActor* AvatarActor = ActorInfo ? ActorInfo->AvatarActor.Get() : nullptr;
+	if (AvatarActor == nullptr || !AvatarActor->HasAuthority() || ProjectileClass == nullptr) return;
+	
+	if (UTopDownProjectilePoolSubsystem* ProjectilePool = AvatarActor->GetWorld()->GetSubsystem<UTopDownProjectilePoolSubsystem>())
+	{
+		ProjectilePool->SetMaxPoolSize(ProjectileClass, ProjectilePoolMaxSize);
+		ProjectilePool->PrewarmPool(ProjectileClass, ProjectilePoolPrewarmCount);
+	}
+}
+
+void UTopDownProjectileAbility::SpawnProjectileAtLocation(const FVector& ProjectileTargetLocation)
+{
+	SpawnProjectile(ProjectileTargetLocation);
+}
 
 void UTopDownProjectileAbility::SpawnProjectile(const FVector& ProjectileTargetLocation)
 {
@@ -41,9 +60,12 @@ void UTopDownProjectileAbility::SpawnProjectile(const FVector& ProjectileTargetL
 		 * This allows you to modify its properties or components before the initialization is finished.
 		 * This is particularly useful for complex setup or when you need to set specific parameters
 		 * that are only available after the actor is partially constructed but not fully initialized.
+		 * The projectile pool works the same way, but hands out a parked projectile when it has one.
 		 */
-		ATopDownProjectile* Projectile = GetWorld()->SpawnActorDeferred<ATopDownProjectile>(ProjectileClass, SpawnTransform, GetOwningActorFromActorInfo(),
-			Cast<APawn>(GetAvatarActorFromActorInfo()), ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		UTopDownProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UTopDownProjectilePoolSubsystem>();
+		check(ProjectilePool);
+		ATopDownProjectile* Projectile = ProjectilePool->SpawnProjectileDeferred(ProjectileClass, SpawnTransform, GetOwningActorFromActorInfo(),
+			Cast<APawn>(GetAvatarActorFromActorInfo()));
 		Projectile->SetInstigator(Cast<APawn>(CurrentActorInfo->AvatarActor));
 		Projectile->SetOwner(Cast<APawn>(CurrentActorInfo->AvatarActor));
 
@@ -79,7 +101,7 @@ void UTopDownProjectileAbility::SpawnProjectile(const FVector& ProjectileTargetL
 		// Assign the damage effect spec handle to the projectile.
 		Projectile->DamageEffectSpecHandle = EffectSpecHandle;
 
-		// Finalize the spawning process for the projectile.
-		Projectile->FinishSpawning(SpawnTransform);
+		// Finalize the spawning process for the projectile, or launch it again if it came from the pool.
+		ProjectilePool->FinishSpawningProjectile(Projectile, SpawnTransform);
 	}
 }
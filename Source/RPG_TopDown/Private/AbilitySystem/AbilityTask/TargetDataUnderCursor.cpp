@@ -4,6 +4,7 @@
 #include "AbilitySystem/AbilityTask/TargetDataUnderCursor.h"
 
 #include "AbilitySystemComponent.h"
+#include "ActorComponent/CursorQueryComponent.h"
 
 
 UTargetDataUnderCursor* UTargetDataUnderCursor::CreateTargetDataUnderCursor(UGameplayAbility* OwningGameplayAbility)
@@ -35,7 +36,16 @@ void UTargetDataUnderCursor::SendTargetDataToServer()
 	FHitResult CursorHitResult;
 	if (Controller)
 	{
-		Controller->GetHitResultUnderCursor(ECC_Visibility, false, CursorHitResult);
+		// Target data is sent to the server, so it always gets a fresh trace rather than a cached hit that may be up to MaxCacheAge old.
+		// The component keeps the result so highlighting can reuse it this frame.
+		if (UCursorQueryComponent* CursorQuery = Controller->FindComponentByClass<UCursorQueryComponent>())
+		{
+			CursorHitResult = CursorQuery->GetFreshVisibilityHit();
+		}
+		else
+		{
+			Controller->GetHitResultUnderCursor(ECC_Visibility, false, CursorHitResult);
+		}
 	}
 
 	FGameplayAbilityTargetDataHandle TargetDataHandle;
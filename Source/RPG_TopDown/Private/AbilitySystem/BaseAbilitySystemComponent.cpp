@@ -6,6 +6,79 @@
 #include "AssetTypeCategories.h"
 #include "TopDownGameplayTags.h"
 #include "AbilitySystem/Abilities/BaseGameplayAbility.h"
+#include "PlayerState/TopDownPlayerState.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+
+DECLARE_CYCLE_STAT(TEXT("Ability Input Dispatch"), STAT_AbilityInputDispatch, STATGROUP_TopDown);
+DECLARE_CYCLE_STAT(TEXT("Ability Input Map Rebuild"), STAT_AbilityInputMapRebuild, STATGROUP_TopDown);
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithArgs CAbilityInputBenchmark(
+	TEXT("TopDown.AbilityInput.Benchmark"),
+	TEXT("Grants <Count> (default 128) abilities spread over the input tags to a transient ability system component and times finding the abilities of an input tag, once with a linear scan and once through the input tag map."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		UBaseAbilitySystemComponent::RunInputDispatchBenchmark(Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 128);
+	}));
+
+void UBaseAbilitySystemComponent::RunInputDispatchBenchmark(int32 AbilityCount)
+{
+	constexpr int32 Passes = 10000;
+	const FTopDownGameplayTags& GameplayTags = FTopDownGameplayTags::Get();
+	const FGameplayTag InputTags[] = { GameplayTags.InputTag_LMB, GameplayTags.InputTag_RMB, GameplayTags.InputTag_1, GameplayTags.InputTag_2, GameplayTags.InputTag_3, GameplayTags.InputTag_4 };
+
+	// Instanced per execution, so granting needs neither an owner nor an avatar.
+	UBaseAbilitySystemComponent* AbilitySystemComponent = NewObject<UBaseAbilitySystemComponent>(GetTransientPackage());
+	for (int32 Index = 0; Index < AbilityCount; ++Index)
+	{
+		FGameplayAbilitySpec GameplayAbilitySpec(UGameplayAbility::StaticClass(), 1);
+		GameplayAbilitySpec.DynamicAbilityTags.AddTag(InputTags[Index % UE_ARRAY_COUNT(InputTags)]);
+		AbilitySystemComponent->GiveAbility(GameplayAbilitySpec);
+	}
+
+	// What ActivateAbilityInputTagHeld did before the map: every input walked every activatable ability.
+	int32 LinearScanMatches = 0;
+	const double LinearScanStart = FPlatformTime::Seconds();
+	for (int32 Pass = 0; Pass < Passes; ++Pass)
+	{
+		for (FGameplayAbilitySpec& AbilitySpec : AbilitySystemComponent->GetActivatableAbilities())
+		{
+			if (AbilitySpec.DynamicAbilityTags.HasTagExact(InputTags[Pass % UE_ARRAY_COUNT(InputTags)]))
+			{
+				++LinearScanMatches;
+			}
+		}
+	}
+	const double LinearScanSeconds = FPlatformTime::Seconds() - LinearScanStart;
+
+	// The first lookup rebuilds the map, like the first input after abilities were granted.
+	int32 TagMapMatches = 0;
+	const double TagMapStart = FPlatformTime::Seconds();
+	for (int32 Pass = 0; Pass < Passes; ++Pass)
+	{
+		if (const FInputTagAbilitySpecArray* AbilitySpecs = AbilitySystemComponent->FindAbilitySpecsForInputTag(InputTags[Pass % UE_ARRAY_COUNT(InputTags)]))
+		{
+			for (const FInputTagAbilitySpec& InputTagAbilitySpec : *AbilitySpecs)
+			{
+				if (AbilitySystemComponent->ResolveInputTagAbilitySpec(InputTagAbilitySpec))
+				{
+					++TagMapMatches;
+				}
+			}
+		}
+	}
+	const double TagMapSeconds = FPlatformTime::Seconds() - TagMapStart;
+
+	UE_LOG(LogTemp, Display, TEXT("Ability input benchmark, %d abilities, %d lookups"), AbilitySystemComponent->GetActivatableAbilities().Num(), Passes);
+	UE_LOG(LogTemp, Display, TEXT("  Linear scan: %.4f us per lookup (%d matches)"), LinearScanSeconds * 1000000.0 / Passes, LinearScanMatches);
+	UE_LOG(LogTemp, Display, TEXT("  Tag map:     %.4f us per lookup (%d matches)"), TagMapSeconds * 1000000.0 / Passes, TagMapMatches);
+
+	AbilitySystemComponent->ClearAllAbilities();
+	AbilitySystemComponent->MarkAsGarbage();
+}
+
+#endif
 
 // Binds the delegate to handle effects applied to the ability system component.
 void UBaseAbilitySystemComponent::BindOnGameplayEffectAppliedDelegateToSelf()
@@ -82,17 +155,24 @@ void UBaseAbilitySystemComponent::AddCharacterAbilities(const TArray<TSubclassOf
 // Ability activation function when Input is held by the player for the given ability
 void UBaseAbilitySystemComponent::ActivateAbilityInputTagHeld(const FGameplayTag& InputTag)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputDispatch);
+	
 	if (!InputTag.IsValid()) return;
 
-	for (auto& ActivatableAbilitySpecs : GetActivatableAbilities())
+	const FInputTagAbilitySpecArray* AbilitySpecs = FindAbilitySpecsForInputTag(InputTag);
+	if (AbilitySpecs == nullptr) return;
+
+	// Activating an ability may give or remove abilities, so we work on a copy and resolve each spec right before using it.
+	const FInputTagAbilitySpecArray InputTagAbilitySpecsCopy = *AbilitySpecs;
+	for (const FInputTagAbilitySpec& InputTagAbilitySpec : InputTagAbilitySpecsCopy)
 	{
-		if (ActivatableAbilitySpecs.DynamicAbilityTags.HasTagExact(InputTag))
+		if (FGameplayAbilitySpec* ActivatableAbilitySpec = ResolveInputTagAbilitySpec(InputTagAbilitySpec))
 		{
-			AbilitySpecInputPressed(ActivatableAbilitySpecs);
-			if (!ActivatableAbilitySpecs.IsActive())
+			AbilitySpecInputPressed(*ActivatableAbilitySpec);
+			if (!ActivatableAbilitySpec->IsActive())
 			{
 				// We have to call tri activate ability because there may be things that prevent the ability from being activated. So we have to try to activate it.
-				TryActivateAbility(ActivatableAbilitySpecs.Handle);
+				TryActivateAbility(InputTagAbilitySpec.Handle);
 			}
 		}
 	}
@@ -101,13 +181,115 @@ void UBaseAbilitySystemComponent::ActivateAbilityInputTagHeld(const FGameplayTag
 // Ability activation function when Input is released by the player for the given ability
 void UBaseAbilitySystemComponent::ActivateAbilityInputTagReleased(const FGameplayTag& InputTag)
 {
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputDispatch);
+	
 	if (!InputTag.IsValid()) return;
 
-	for (auto& ActivatableAbilitySpecs : GetActivatableAbilities())
+	const FInputTagAbilitySpecArray* AbilitySpecs = FindAbilitySpecsForInputTag(InputTag);
+	if (AbilitySpecs == nullptr) return;
+
+	const FInputTagAbilitySpecArray InputTagAbilitySpecsCopy = *AbilitySpecs;
+	for (const FInputTagAbilitySpec& InputTagAbilitySpec : InputTagAbilitySpecsCopy)
+	{
+		if (FGameplayAbilitySpec* ActivatableAbilitySpec = ResolveInputTagAbilitySpec(InputTagAbilitySpec))
+		{
+			AbilitySpecInputReleased(*ActivatableAbilitySpec);
+		}
+	}
+}
+
+void UBaseAbilitySystemComponent::SetAbilityInputTag(FGameplayAbilitySpecHandle AbilitySpecHandle, const FGameplayTag& InputTag)
+{
+	FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandle(AbilitySpecHandle);
+	if (AbilitySpec == nullptr) return;
+
+	// An ability only ever has one input tag, drop the old one first.
+	const FGameplayTag InputTagParent = FGameplayTag::RequestGameplayTag(FName("InputTag"));
+	FGameplayTagContainer OldInputTags;
+	for (const FGameplayTag& DynamicAbilityTag : AbilitySpec->DynamicAbilityTags)
+	{
+		if (DynamicAbilityTag.MatchesTag(InputTagParent))
+		{
+			OldInputTags.AddTag(DynamicAbilityTag);
+		}
+	}
+	AbilitySpec->DynamicAbilityTags.RemoveTags(OldInputTags);
+	if (InputTag.IsValid())
+	{
+		AbilitySpec->DynamicAbilityTags.AddTag(InputTag);
+	}
+	
+	MarkAbilitySpecDirty(*AbilitySpec);
+	bInputTagAbilitySpecsDirty = true;
+}
+
+void UBaseAbilitySystemComponent::ForceReplication()
+{
+	Super::ForceReplication();
+
+	// Effects and abilities changing on the server end up here, right before the owner is force net updated.
+	if (ATopDownPlayerState* TopDownPlayerState = Cast<ATopDownPlayerState>(GetOwnerActor()))
+	{
+		TopDownPlayerState->MarkNetActivity();
+	}
+}
+
+void UBaseAbilitySystemComponent::OnGiveAbility(FGameplayAbilitySpec& AbilitySpec)
+{
+	Super::OnGiveAbility(AbilitySpec);
+	bInputTagAbilitySpecsDirty = true;
+}
+
+void UBaseAbilitySystemComponent::OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec)
+{
+	Super::OnRemoveAbility(AbilitySpec);
+	bInputTagAbilitySpecsDirty = true;
+}
+
+void UBaseAbilitySystemComponent::OnRep_ActivateAbilities()
+{
+	Super::OnRep_ActivateAbilities();
+	// Covers specs added, removed or re-tagged on the server.
+	bInputTagAbilitySpecsDirty = true;
+}
+
+const UBaseAbilitySystemComponent::FInputTagAbilitySpecArray* UBaseAbilitySystemComponent::FindAbilitySpecsForInputTag(const FGameplayTag& InputTag)
+{
+	if (bInputTagAbilitySpecsDirty)
+	{
+		RebuildInputTagAbilitySpecs();
+	}
+	return InputTagAbilitySpecs.Find(InputTag);
+}
+
+FGameplayAbilitySpec* UBaseAbilitySystemComponent::ResolveInputTagAbilitySpec(const FInputTagAbilitySpec& InputTagAbilitySpec)
+{
+	TArray<FGameplayAbilitySpec>& ActivatableAbilitySpecs = GetActivatableAbilities();
+	if (ActivatableAbilitySpecs.IsValidIndex(InputTagAbilitySpec.SpecIndex) &&
+		ActivatableAbilitySpecs[InputTagAbilitySpec.SpecIndex].Handle == InputTagAbilitySpec.Handle)
+	{
+		return &ActivatableAbilitySpecs[InputTagAbilitySpec.SpecIndex];
+	}
+
+	// The list changed under us without a give/remove notification (e.g. pending adds inside an ability scope lock).
+	bInputTagAbilitySpecsDirty = true;
+	return FindAbilitySpecFromHandle(InputTagAbilitySpec.Handle);
+}
+
+void UBaseAbilitySystemComponent::RebuildInputTagAbilitySpecs()
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputMapRebuild);
+	
+	InputTagAbilitySpecs.Reset();
+	
+	const TArray<FGameplayAbilitySpec>& ActivatableAbilitySpecs = GetActivatableAbilities();
+	for (int32 SpecIndex = 0; SpecIndex < ActivatableAbilitySpecs.Num(); ++SpecIndex)
 	{
-		if (ActivatableAbilitySpecs.DynamicAbilityTags.HasTagExact(InputTag))
+		const FGameplayAbilitySpec& AbilitySpec = ActivatableAbilitySpecs[SpecIndex];
+		for (const FGameplayTag& DynamicAbilityTag : AbilitySpec.DynamicAbilityTags)
 		{
-			AbilitySpecInputReleased(ActivatableAbilitySpecs);
+			InputTagAbilitySpecs.FindOrAdd(DynamicAbilityTag).Add({AbilitySpec.Handle, SpecIndex});
 		}
 	}
+	bInputTagAbilitySpecsDirty = false;
 }
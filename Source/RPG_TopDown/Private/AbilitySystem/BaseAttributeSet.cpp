@@ -5,6 +5,7 @@
 
 #include "AbilitySystemBlueprintLibrary.h"
 #include "GameplayEffectExtension.h"
+#include "TopDownCombatTrace.h"
 #include "TopDownGameplayTags.h"
 #include "AbilitySystem/TopDownAbilitySystemLibrary.h"
 #include "Controller/Player/PlayerCharacterController.h"
@@ -12,6 +13,149 @@
 #include "Interface/Interaction/CombatInterface.h"
 #include "Kismet/GameplayStatics.h"
 #include "Net/UnrealNetwork.h"
+#include "PlayerState/TopDownPlayerState.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+#include "Subsystem/TopDownCombatLogSubsystem.h"
+#include "Subsystem/TopDownCombatSimulationSubsystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Attribute Set Effect Executions"), STAT_AttributeSetEffectExecutions, STATGROUP_TopDown);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effect Context Resolves"), STAT_EffectContextResolves, STATGROUP_TopDown);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effect Context Allocations Avoided"), STAT_EffectContextAllocationsAvoided, STATGROUP_TopDown);
+
+// MakeShared calls the execution context made per execution before it moved to the stack: the context handle and the source and target property structs.
+static constexpr uint32 LegacyEffectContextAllocations = 3;
+
+#if !UE_BUILD_SHIPPING
+namespace TopDownAttributeReplication
+{
+	struct FReplicationCounter
+	{
+		uint64 Changes = 0;
+		uint64 Bits = 0;
+	};
+
+	// Server side. Nothing is recorded until the report is started.
+	static bool bRecording = false;
+
+	// Full attributes count their changes, keyed by the attribute's property so recording never builds a name.
+	static TMap<const FProperty*, FReplicationCounter> AttributeCounters;
+	// The packed vitals count what NetSerialize wrote.
+	static FReplicationCounter VitalsCounter;
+
+	// A replicated FGameplayAttributeData carries its base and current value.
+	static constexpr uint64 FullAttributeBits = 2 * 32;
+
+	static void AddToCounter(FReplicationCounter& Counter, const uint64 Bits)
+	{
+		++Counter.Changes;
+		Counter.Bits += Bits;
+	}
+
+	static void RecordAttribute(const FGameplayAttribute& Attribute)
+	{
+		if (!bRecording) return;
+		AddToCounter(AttributeCounters.FindOrAdd(Attribute.GetUProperty()), FullAttributeBits);
+	}
+
+	static void RecordVitals(const uint64 Bits)
+	{
+		if (!bRecording) return;
+		AddToCounter(VitalsCounter, Bits);
+	}
+
+	static void Report(const TArray<FString>& Args)
+	{
+		if (Args.Num() > 0)
+		{
+			if (Args[0] == TEXT("start"))
+			{
+				bRecording = true;
+			}
+			else if (Args[0] == TEXT("stop"))
+			{
+				bRecording = false;
+			}
+			else if (Args[0] == TEXT("reset"))
+			{
+				AttributeCounters.Reset();
+				VitalsCounter = FReplicationCounter();
+			}
+			return;
+		}
+
+		// Names are only looked up here, when printing.
+		TArray<TPair<FString, FReplicationCounter>> Rows;
+		for (const TPair<const FProperty*, FReplicationCounter>& Counter : AttributeCounters)
+		{
+			Rows.Emplace(Counter.Key ? Counter.Key->GetName() : FString(TEXT("None")), Counter.Value);
+		}
+		Rows.Emplace(TEXT("ReplicatedVitals"), VitalsCounter);
+		Rows.Sort([](const TPair<FString, FReplicationCounter>& A, const TPair<FString, FReplicationCounter>& B) { return A.Value.Bits > B.Value.Bits; });
+
+		uint64 TotalBits = 0;
+		UE_LOG(LogTemp, Display, TEXT("%-24s %10s %12s"), TEXT("Attribute"), TEXT("Changes"), TEXT("Bytes"));
+		for (const TPair<FString, FReplicationCounter>& Row : Rows)
+		{
+			UE_LOG(LogTemp, Display, TEXT("%-24s %10llu %12llu"), *Row.Key, Row.Value.Changes, Row.Value.Bits / 8);
+			TotalBits += Row.Value.Bits;
+		}
+		UE_LOG(LogTemp, Display, TEXT("Total: %llu bytes. Full attributes are counted once per change, ReplicatedVitals once per connection it was sent to.%s"),
+			TotalBits / 8, bRecording ? TEXT("") : TEXT(" Not recording, run with 'start' first."));
+	}
+}
+
+static FAutoConsoleCommand CAttributeReplicationReport(
+	TEXT("TopDown.AttributeReplicationReport"),
+	TEXT("Logs how often each attribute changed on the server and the estimated replicated bytes. 'start' and 'stop' toggle recording, 'reset' clears the counters."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&TopDownAttributeReplication::Report));
+#endif
+
+// One decimal is plenty for a health bar.
+static uint32 QuantizeVital(const float Value)
+{
+	return static_cast<uint32>(FMath::RoundToInt(FMath::Max(Value, 0.f) * 10.f));
+}
+
+bool FPackedVitalAttributes::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	float* const Values[] = { &Health, &MaxHealth, &Mana, &MaxMana, &Stamina, &MaxStamina };
+#if !UE_BUILD_SHIPPING
+	uint64 Bits = 0;
+#endif
+	for (float* Value : Values)
+	{
+		uint32 PackedValue = Ar.IsSaving() ? QuantizeVital(*Value) : 0;
+		Ar.SerializeIntPacked(PackedValue);
+		if (Ar.IsLoading())
+		{
+			*Value = PackedValue / 10.f;
+		}
+#if !UE_BUILD_SHIPPING
+		// SerializeIntPacked writes a byte per 7 bits of value.
+		Bits += 8 * FMath::Max(1u, FMath::DivideAndRoundUp(32u - FMath::CountLeadingZeros(PackedValue), 7u));
+#endif
+	}
+#if !UE_BUILD_SHIPPING
+	if (Ar.IsSaving())
+	{
+		TopDownAttributeReplication::RecordVitals(Bits);
+	}
+#endif
+	
+	bOutSuccess = true;
+	return true;
+}
+
+bool FPackedVitalAttributes::operator==(const FPackedVitalAttributes& Other) const
+{
+	// Compared at the replicated precision, so changes below it do not cause an update.
+	return QuantizeVital(Health) == QuantizeVital(Other.Health) &&
+		QuantizeVital(MaxHealth) == QuantizeVital(Other.MaxHealth) &&
+		QuantizeVital(Mana) == QuantizeVital(Other.Mana) &&
+		QuantizeVital(MaxMana) == QuantizeVital(Other.MaxMana) &&
+		QuantizeVital(Stamina) == QuantizeVital(Other.Stamina) &&
+		QuantizeVital(MaxStamina) == QuantizeVital(Other.MaxStamina);
+}
 
 	/*
 	 * GAMEPLAYATTRIBUTE_REPNOTIFY macro handles the boilerplate code for notifying clients of attribute changes.
@@ -37,87 +181,92 @@ void UBaseAttributeSet::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Ou
 
 	/*
 	 * Primary Attributes
+	 * Only the owner shows them (attribute menu), the damage calculation runs on the server.
 	 */
 	// Setup replication for Strength attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Strength, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Strength, COND_OwnerOnly, REPNOTIFY_Always);
 	
 	// Setup replication for Dexterity attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Dexterity, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Dexterity, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for Intelligence attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Intelligence, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Intelligence, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for Resilience attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Resilience, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Resilience, COND_OwnerOnly, REPNOTIFY_Always);
 	
 	// Setup replication for Vigor attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Vigor, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Vigor, COND_OwnerOnly, REPNOTIFY_Always);
 
 	/*
 	 * Secondary Attributes
+	 * Owner only as well. Everyone else gets MaxHealth, MaxMana and MaxStamina through ReplicatedVitals.
 	 */
 	// Setup replication for AttackPower attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, AttackPower, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, AttackPower, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for SpellPower attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, SpellPower, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, SpellPower, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for Armor attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Armor, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Armor, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for MagicResistance attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MagicResistance, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MagicResistance, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for ArmorPenetration attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, ArmorPenetration, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, ArmorPenetration, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for BlockChance attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, BlockChance, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, BlockChance, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for CriticalHitChance attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, CriticalHitChance, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, CriticalHitChance, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for CriticalHitDamage attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, CriticalHitDamage, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, CriticalHitDamage, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for CriticalHitResistance attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, CriticalHitResistance, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, CriticalHitResistance, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for Evasion attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Evasion, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Evasion, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for MovementSpeed attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MovementSpeed, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MovementSpeed, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for HealthRegeneration attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, HealthRegeneration, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, HealthRegeneration, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for ManaRegeneration attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, ManaRegeneration, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, ManaRegeneration, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for StaminaRegeneration attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, StaminaRegeneration, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, StaminaRegeneration, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for MaxHealth attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MaxHealth, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MaxHealth, COND_OwnerOnly, REPNOTIFY_Always);
 
 	// Setup replication for MaxMana attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MaxMana, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MaxMana, COND_OwnerOnly, REPNOTIFY_Always);
 	
 	// Setup replication for MaxStamina attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MaxStamina, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MaxStamina, COND_OwnerOnly, REPNOTIFY_Always);
 	
 	/*
 	 * Vital Attributes
+	 * Full precision for the owner, packed through ReplicatedVitals for everyone else.
 	 */
     // Setup replication for Health attribute
-    DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Health, COND_None, REPNOTIFY_Always);
+    DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Health, COND_OwnerOnly, REPNOTIFY_Always);
     
     // Setup replication for Mana attribute
-    DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Mana, COND_None, REPNOTIFY_Always);
+    DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Mana, COND_OwnerOnly, REPNOTIFY_Always);
 	
 	// Setup replication for Stamina attribute
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Stamina, COND_None, REPNOTIFY_Always);
+	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Stamina, COND_OwnerOnly, REPNOTIFY_Always);
+
+	DOREPLIFETIME_CONDITION(UBaseAttributeSet, ReplicatedVitals, COND_SkipOwner);
 }
 
 /*
@@ -162,46 +311,71 @@ void UBaseAttributeSet::PreAttributeChange(const FGameplayAttribute& Attribute,
 	}*/
 }
 
-/*
- * The function is responsible for setting up and populating the FGameplayEffectExecutionContext struct.
- */
-void UBaseAttributeSet::InitializeEffectExecutionContext(const FGameplayEffectModCallbackData& Data, FGameplayEffectContextDetails& GameplayEffectContextDetails) const
+FGameplayEffectContextDetails::FGameplayEffectContextDetails(const FGameplayEffectModCallbackData& InData)
+	: Data(InData)
+	, GameplayEffectContextHandle(InData.EffectSpec.GetContext())
+{
+}
+
+const FGameplayEffectContextInfo& FGameplayEffectContextDetails::GetSourceProperties()
+{
+	if (!bSourcePropertiesResolved)
+	{
+		ResolveSourceProperties();
+	}
+	return SourceProperties;
+}
+
+const FGameplayEffectContextInfo& FGameplayEffectContextDetails::GetTargetProperties()
 {
-	// Initialize the context details struct 
-	GameplayEffectContextDetails.GameplayEffectContextHandle = MakeShared<FGameplayEffectContextHandle>(Data.EffectSpec.GetContext());
+	if (!bTargetPropertiesResolved)
+	{
+		ResolveTargetProperties();
+	}
+	return TargetProperties;
+}
 
-	// Populate source properties
-	GameplayEffectContextDetails.SourceProperties->AbilitySystemComponent = GameplayEffectContextDetails.GameplayEffectContextHandle->GetOriginalInstigatorAbilitySystemComponent();
+void FGameplayEffectContextDetails::ResolveSourceProperties()
+{
+	INC_DWORD_STAT(STAT_EffectContextResolves);
+	TOPDOWN_COMBAT_SIMULATION_COUNT(ContextResolves, 1);
+	bSourcePropertiesResolved = true;
 	
-	if (IsValid(GameplayEffectContextDetails.SourceProperties->AbilitySystemComponent) &&
-		GameplayEffectContextDetails.SourceProperties->AbilitySystemComponent->AbilityActorInfo.IsValid() &&
-		GameplayEffectContextDetails.SourceProperties->AbilitySystemComponent->AbilityActorInfo->AvatarActor.IsValid())
+	SourceProperties.AbilitySystemComponent = GameplayEffectContextHandle.GetOriginalInstigatorAbilitySystemComponent();
+	
+	if (IsValid(SourceProperties.AbilitySystemComponent) &&
+		SourceProperties.AbilitySystemComponent->AbilityActorInfo.IsValid() &&
+		SourceProperties.AbilitySystemComponent->AbilityActorInfo->AvatarActor.IsValid())
 	{
-		GameplayEffectContextDetails.SourceProperties->AvatarActor = GameplayEffectContextDetails.SourceProperties->AbilitySystemComponent->AbilityActorInfo->AvatarActor.Get();
-		GameplayEffectContextDetails.SourceProperties->Controller = GameplayEffectContextDetails.SourceProperties->AbilitySystemComponent->AbilityActorInfo->PlayerController.Get();
-		if (GameplayEffectContextDetails.SourceProperties->Controller == nullptr && GameplayEffectContextDetails.SourceProperties->AvatarActor != nullptr)
+		SourceProperties.AvatarActor = SourceProperties.AbilitySystemComponent->AbilityActorInfo->AvatarActor.Get();
+		SourceProperties.Controller = SourceProperties.AbilitySystemComponent->AbilityActorInfo->PlayerController.Get();
+		if (SourceProperties.Controller == nullptr && SourceProperties.AvatarActor != nullptr)
 		{
-			if (const APawn* Pawn = Cast<APawn>(GameplayEffectContextDetails.SourceProperties->AvatarActor))
+			if (const APawn* Pawn = Cast<APawn>(SourceProperties.AvatarActor))
 			{
-				GameplayEffectContextDetails.SourceProperties->Controller = Pawn->GetController();
+				SourceProperties.Controller = Pawn->GetController();
 			}
 		}
-		if (GameplayEffectContextDetails.SourceProperties->Controller)
+		if (SourceProperties.Controller)
 		{
-			GameplayEffectContextDetails.SourceProperties->Character = Cast<ACharacter>(GameplayEffectContextDetails.SourceProperties->Controller->GetPawn());
+			SourceProperties.Character = Cast<ACharacter>(SourceProperties.Controller->GetPawn());
 		}
 	}
+}
 
-	// Populate target properties
+void FGameplayEffectContextDetails::ResolveTargetProperties()
+{
+	INC_DWORD_STAT(STAT_EffectContextResolves);
+	TOPDOWN_COMBAT_SIMULATION_COUNT(ContextResolves, 1);
+	bTargetPropertiesResolved = true;
+	
 	if (Data.Target.AbilityActorInfo.IsValid() && Data.Target.AbilityActorInfo->AvatarActor.IsValid())
 	{
-		GameplayEffectContextDetails.TargetProperties->AvatarActor = Data.Target.AbilityActorInfo->AvatarActor.Get();
-		GameplayEffectContextDetails.TargetProperties->Controller = Data.Target.AbilityActorInfo->PlayerController.Get();
-		GameplayEffectContextDetails.TargetProperties->Character = Cast<ACharacter>(GameplayEffectContextDetails.TargetProperties->AvatarActor);
-		GameplayEffectContextDetails.TargetProperties->AbilitySystemComponent = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(GameplayEffectContextDetails.TargetProperties->AvatarActor);
+		TargetProperties.AvatarActor = Data.Target.AbilityActorInfo->AvatarActor.Get();
+		TargetProperties.Controller = Data.Target.AbilityActorInfo->PlayerController.Get();
+		TargetProperties.Character = Cast<ACharacter>(TargetProperties.AvatarActor);
+		TargetProperties.AbilitySystemComponent = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(TargetProperties.AvatarActor);
 	}
-
-	// Now you can use EffectContextDetails to access all the gathered information
 }
 
 /*
@@ -214,9 +388,13 @@ void UBaseAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallba
 {
     Super::PostGameplayEffectExecute(Data);
 
-    // The function is responsible for setting up and populating the FGameplayEffectExecutionContext struct.
-    FGameplayEffectContextDetails GameplayEffectContextDetails;
-    InitializeEffectExecutionContext(Data, GameplayEffectContextDetails);
+    INC_DWORD_STAT(STAT_AttributeSetEffectExecutions);
+    INC_DWORD_STAT_BY(STAT_EffectContextAllocationsAvoided, LegacyEffectContextAllocations);
+    TOPDOWN_COMBAT_SIMULATION_COUNT(EffectExecutions, 1);
+    TOPDOWN_COMBAT_SIMULATION_COUNT(ContextAllocationsAvoided, LegacyEffectContextAllocations);
+    
+    // Source and target are only looked up by the branches below that need them.
+    FGameplayEffectContextDetails GameplayEffectContextDetails(Data);
 
     // Clamping Vital Attributes: Ensures that the vital attributes (Health, Mana, Stamina) are within their valid ranges.
     
@@ -225,8 +403,8 @@ void UBaseAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallba
     {
         // Clamps the Health value to ensure it does not go below 0 or above MaxHealth.
         SetHealth(FMath::Clamp(GetHealth(), 0.f, GetMaxHealth()));
-        // Logs the new Health value for debugging purposes.
-        UE_LOG(LogTemp, Warning, TEXT("Changed Health on %s, Health: %f"), *GameplayEffectContextDetails.TargetProperties->AvatarActor->GetName(), GetHealth());
+        // Sends the new Health value to Insights when the combat trace channel is on.
+        TOPDOWN_TRACE_HEALTH_CHANGED(GameplayEffectContextDetails.GetTargetProperties().AvatarActor, GetHealth(), GetMaxHealth(), Data.EvaluatedData.Magnitude);
     }
 
     // If the attribute modified by the gameplay effect is Mana, clamp the Mana value between 0 and MaxMana.
@@ -255,14 +433,26 @@ void UBaseAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallba
 
     	// Determine if the damage was fatal (i.e., Health dropped to 0 or below).
     	const bool bFatal = NewHealth <= 0.f;
+
+    	if (UTopDownCombatLogSubsystem* CombatLog = UTopDownCombatLogSubsystem::Get(GetOwningActor()))
+    	{
+    		const FGameplayEffectContextHandle& ContextHandle = GameplayEffectContextDetails.GetContextHandle();
+    		// The set by caller damage is the pre-mitigation value on the execution path and already resolved on the batched one.
+    		const float RawDamage = Data.EffectSpec.GetSetByCallerMagnitude(FTopDownGameplayTags::Get().Damage, false, LocalIncomingDamage);
+    		CombatLog->RecordDamage(ETopDownCombatEventType::DamageApplied, GameplayEffectContextDetails.GetSourceProperties().AvatarActor,
+    			GameplayEffectContextDetails.GetTargetProperties().AvatarActor, RawDamage, LocalIncomingDamage,
+    			UTopDownCombatLogSubsystem::MakeDamageFlags(UTopDownAbilitySystemLibrary::GetIsEvaded(ContextHandle),
+    				UTopDownAbilitySystemLibrary::GetIsBlockedHit(ContextHandle), UTopDownAbilitySystemLibrary::GetIsCriticalHit(ContextHandle), bFatal));
+    	}
+
     	if (bFatal)
     	{
-    		const bool bEvadedHit = UTopDownAbilitySystemLibrary::GetIsEvaded(*GameplayEffectContextDetails.GameplayEffectContextHandle.Get());
-    		const bool bCriticalHit = UTopDownAbilitySystemLibrary::GetIsCriticalHit(*GameplayEffectContextDetails.GameplayEffectContextHandle.Get());
-    		const bool bBlockChance = UTopDownAbilitySystemLibrary::GetIsBlockedHit(*GameplayEffectContextDetails.GameplayEffectContextHandle.Get());
+    		const bool bEvadedHit = UTopDownAbilitySystemLibrary::GetIsEvaded(GameplayEffectContextDetails.GetContextHandle());
+    		const bool bCriticalHit = UTopDownAbilitySystemLibrary::GetIsCriticalHit(GameplayEffectContextDetails.GetContextHandle());
+    		const bool bBlockChance = UTopDownAbilitySystemLibrary::GetIsBlockedHit(GameplayEffectContextDetails.GetContextHandle());
     		ShowFloatingDamageText(GameplayEffectContextDetails, LocalIncomingDamage, bEvadedHit, bCriticalHit, bBlockChance);
     		
-    		ICombatInterface* CombatInterface = Cast<ICombatInterface>(GameplayEffectContextDetails.TargetProperties->AvatarActor);
+    		ICombatInterface* CombatInterface = Cast<ICombatInterface>(GameplayEffectContextDetails.GetTargetProperties().AvatarActor);
     		if (CombatInterface)
     		{
     			CombatInterface->Die();
@@ -274,10 +464,10 @@ void UBaseAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallba
     		FGameplayTagContainer GameplayTagContainer;
     		GameplayTagContainer.AddTag(FTopDownGameplayTags::Get().Effects_HitReact);
     		// Try to activate any abilities associated with the hit reaction tag.
-    		GameplayEffectContextDetails.TargetProperties->AbilitySystemComponent->TryActivateAbilitiesByTag(GameplayTagContainer);
-    		const bool bEvadedHit = UTopDownAbilitySystemLibrary::GetIsEvaded(*GameplayEffectContextDetails.GameplayEffectContextHandle.Get());
-    		const bool bCriticalHit = UTopDownAbilitySystemLibrary::GetIsCriticalHit(*GameplayEffectContextDetails.GameplayEffectContextHandle.Get());
-    		const bool bBlockChance = UTopDownAbilitySystemLibrary::GetIsBlockedHit(*GameplayEffectContextDetails.GameplayEffectContextHandle.Get());
+    		GameplayEffectContextDetails.GetTargetProperties().AbilitySystemComponent->TryActivateAbilitiesByTag(GameplayTagContainer);
+    		const bool bEvadedHit = UTopDownAbilitySystemLibrary::GetIsEvaded(GameplayEffectContextDetails.GetContextHandle());
+    		const bool bCriticalHit = UTopDownAbilitySystemLibrary::GetIsCriticalHit(GameplayEffectContextDetails.GetContextHandle());
+    		const bool bBlockChance = UTopDownAbilitySystemLibrary::GetIsBlockedHit(GameplayEffectContextDetails.GetContextHandle());
     		ShowFloatingDamageText(GameplayEffectContextDetails, LocalIncomingDamage, bEvadedHit, bCriticalHit, bBlockChance);
     	}
     	
@@ -289,14 +479,56 @@ void UBaseAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallba
     }
 }
 
-void UBaseAttributeSet::ShowFloatingDamageText(const FGameplayEffectContextDetails& GameplayEffectContextDetails, const float Damage, bool bEvadedHit, bool bCriticalHit, bool bBlockChance) const
+void UBaseAttributeSet::PostAttributeChange(const FGameplayAttribute& Attribute, float OldValue, float NewValue)
 {
-	if (GameplayEffectContextDetails.SourceProperties->Character != GameplayEffectContextDetails.TargetProperties->Character)
+	Super::PostAttributeChange(Attribute, OldValue, NewValue);
+
+	AActor* OwningActor = GetOwningActor();
+	if (OwningActor == nullptr || !OwningActor->HasAuthority()) return;
+
+	if (ATopDownPlayerState* TopDownPlayerState = Cast<ATopDownPlayerState>(OwningActor))
+	{
+		TopDownPlayerState->MarkNetActivity();
+	}
+
+#if !UE_BUILD_SHIPPING
+	TopDownAttributeReplication::RecordAttribute(Attribute);
+#endif
+
+	if (Attribute == GetHealthAttribute())
+	{
+		ReplicatedVitals.Health = NewValue;
+	}
+	else if (Attribute == GetMaxHealthAttribute())
+	{
+		ReplicatedVitals.MaxHealth = NewValue;
+	}
+	else if (Attribute == GetManaAttribute())
+	{
+		ReplicatedVitals.Mana = NewValue;
+	}
+	else if (Attribute == GetMaxManaAttribute())
+	{
+		ReplicatedVitals.MaxMana = NewValue;
+	}
+	else if (Attribute == GetStaminaAttribute())
+	{
+		ReplicatedVitals.Stamina = NewValue;
+	}
+	else if (Attribute == GetMaxStaminaAttribute())
+	{
+		ReplicatedVitals.MaxStamina = NewValue;
+	}
+}
+
+void UBaseAttributeSet::ShowFloatingDamageText(FGameplayEffectContextDetails& GameplayEffectContextDetails, const float Damage, bool bEvadedHit, bool bCriticalHit, bool bBlockChance) const
+{
+	if (GameplayEffectContextDetails.GetSourceProperties().Character != GameplayEffectContextDetails.GetTargetProperties().Character)
 	{
 		if (APlayerCharacterController* PlayerCharacterController = Cast<APlayerCharacterController>(
-			UGameplayStatics::GetPlayerController(GameplayEffectContextDetails.SourceProperties->Character, 0)))
+			UGameplayStatics::GetPlayerController(GameplayEffectContextDetails.GetSourceProperties().Character, 0)))
 		{
-			PlayerCharacterController->ShowDamageNumber(Damage, GameplayEffectContextDetails.TargetProperties->Character, bEvadedHit, bCriticalHit, bBlockChance);
+			PlayerCharacterController->ShowDamageNumber(Damage, GameplayEffectContextDetails.GetTargetProperties().Character, bEvadedHit, bCriticalHit, bBlockChance);
 		}
 	}
 }
@@ -441,3 +673,24 @@ void UBaseAttributeSet::OnRep_Stamina(const FGameplayAttributeData& OldStamina)
 {
 	GAMEPLAYATTRIBUTE_REPNOTIFY(UBaseAttributeSet, Stamina, OldStamina);
 }
+
+void UBaseAttributeSet::OnRep_ReplicatedVitals()
+{
+	// Maximums first, so listeners never see a current value above its maximum.
+	ApplyReplicatedVital(MaxHealth, ReplicatedVitals.MaxHealth, &UBaseAttributeSet::OnRep_MaxHealth);
+	ApplyReplicatedVital(MaxMana, ReplicatedVitals.MaxMana, &UBaseAttributeSet::OnRep_MaxMana);
+	ApplyReplicatedVital(MaxStamina, ReplicatedVitals.MaxStamina, &UBaseAttributeSet::OnRep_MaxStamina);
+	ApplyReplicatedVital(Health, ReplicatedVitals.Health, &UBaseAttributeSet::OnRep_Health);
+	ApplyReplicatedVital(Mana, ReplicatedVitals.Mana, &UBaseAttributeSet::OnRep_Mana);
+	ApplyReplicatedVital(Stamina, ReplicatedVitals.Stamina, &UBaseAttributeSet::OnRep_Stamina);
+}
+
+void UBaseAttributeSet::ApplyReplicatedVital(FGameplayAttributeData& AttributeData, const float NewValue, void (UBaseAttributeSet::*OnRepFunction)(const FGameplayAttributeData&) const)
+{
+	if (AttributeData.GetBaseValue() == NewValue && AttributeData.GetCurrentValue() == NewValue) return;
+	
+	const FGameplayAttributeData OldAttributeData = AttributeData;
+	AttributeData.SetBaseValue(NewValue);
+	AttributeData.SetCurrentValue(NewValue);
+	(this->*OnRepFunction)(OldAttributeData);
+}
@@ -7,12 +7,10 @@
 FTopDownAttributeInfo UAttributeInfoDataAsset::FindAttributeInfoForTag(const FGameplayTag& AttributeTag,
 	bool bLogNotFound) const
 {
-	for (const FTopDownAttributeInfo& AttributeInfo : AttributeInformation)
+	const int32 AttributeIndex = FindAttributeInfoIndex(AttributeTag);
+	if (AttributeIndex != INDEX_NONE)
 	{
-		if (AttributeInfo.AttributeTag.MatchesTagExact(AttributeTag))
-		{
-			return AttributeInfo;
-		}
+		return AttributeInformation[AttributeIndex];
 	}
 
 	if (bLogNotFound)
@@ -22,3 +20,50 @@ FTopDownAttributeInfo UAttributeInfoDataAsset::FindAttributeInfoForTag(const FGa
 
 	return FTopDownAttributeInfo();
 }
+
+int32 UAttributeInfoDataAsset::FindAttributeInfoIndex(const FGameplayTag& AttributeTag) const
+{
+	if (const int32* AttributeIndex = AttributeIndexByTag.Find(AttributeTag))
+	{
+		return *AttributeIndex;
+	}
+
+	// Not indexed yet, e.g. an asset created this session that hasn't been loaded or edited. Fall back to the scan.
+	if (AttributeIndexByTag.Num() != AttributeInformation.Num())
+	{
+		return AttributeInformation.IndexOfByPredicate([&AttributeTag](const FTopDownAttributeInfo& AttributeInfo)
+		{
+			return AttributeInfo.AttributeTag.MatchesTagExact(AttributeTag);
+		});
+	}
+	return INDEX_NONE;
+}
+
+void UAttributeInfoDataAsset::PostLoad()
+{
+	Super::PostLoad();
+
+	BuildAttributeIndex();
+}
+
+#if WITH_EDITOR
+void UAttributeInfoDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	BuildAttributeIndex();
+}
+#endif
+
+void UAttributeInfoDataAsset::BuildAttributeIndex()
+{
+	AttributeIndexByTag.Reset();
+	for (int32 AttributeIndex = 0; AttributeIndex < AttributeInformation.Num(); ++AttributeIndex)
+	{
+		// First entry wins, like the linear search did.
+		if (!AttributeIndexByTag.Contains(AttributeInformation[AttributeIndex].AttributeTag))
+		{
+			AttributeIndexByTag.Add(AttributeInformation[AttributeIndex].AttributeTag, AttributeIndex);
+		}
+	}
+}
@@ -3,7 +3,131 @@
 
 #include "AbilitySystem/Data/CharacterClassInfoDataAsset.h"
 
+#include "Engine/CurveTable.h"
+
+// Curve table row name of every EDamageCoefficient entry, built from the enum once instead of on every lookup.
+static FName GetDamageCoefficientRowName(uint8 CoefficientIndex)
+{
+	static const TArray<FName> RowNames = []()
+	{
+		TArray<FName> Names;
+		const UEnum* CoefficientEnum = StaticEnum<EDamageCoefficient>();
+		for (uint8 Index = 0; Index < static_cast<uint8>(EDamageCoefficient::MAX); ++Index)
+		{
+			Names.Add(FName(CoefficientEnum->GetNameStringByValue(Index)));
+		}
+		return Names;
+	}();
+	return RowNames[CoefficientIndex];
+}
+
 FCharacterClassDefaultInfo UCharacterClassInfoDataAsset::GetCharacterClassDefaultInfo(ECharacterClass CharacterClass)
 {
 	return CharacterClassInformation.FindChecked(CharacterClass);
 }
+
+float UCharacterClassInfoDataAsset::GetDamageCoefficient(EDamageCoefficient Coefficient, int32 Level) const
+{
+	check(Coefficient < EDamageCoefficient::MAX);
+	
+	const TArray<float>& BakedCoefficients = BakedDamageCoefficients[static_cast<uint8>(Coefficient)];
+	if (BakedCoefficients.IsValidIndex(Level))
+	{
+		return BakedCoefficients[Level];
+	}
+	return EvaluateDamageCoefficientCurve(Coefficient, Level);
+}
+
+void UCharacterClassInfoDataAsset::PostLoad()
+{
+	Super::PostLoad();
+
+	BakeDamageCoefficients();
+#if WITH_EDITOR
+	BindCurveTableChanged();
+#endif
+}
+
+void UCharacterClassInfoDataAsset::BeginDestroy()
+{
+#if WITH_EDITOR
+	UnbindCurveTableChanged();
+#endif
+	Super::BeginDestroy();
+}
+
+#if WITH_EDITOR
+void UCharacterClassInfoDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	const FName PropertyName = PropertyChangedEvent.GetMemberPropertyName();
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(UCharacterClassInfoDataAsset, DamageCalculationCoefficients) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(UCharacterClassInfoDataAsset, MaxBakedCoefficientLevel))
+	{
+		BakeDamageCoefficients();
+		BindCurveTableChanged();
+	}
+}
+
+void UCharacterClassInfoDataAsset::BindCurveTableChanged()
+{
+	UnbindCurveTableChanged();
+
+	if (DamageCalculationCoefficients)
+	{
+		BoundCurveTable = DamageCalculationCoefficients;
+		CurveTableChangedHandle = DamageCalculationCoefficients->OnCurveTableChanged().AddUObject(this, &UCharacterClassInfoDataAsset::BakeDamageCoefficients);
+	}
+}
+
+void UCharacterClassInfoDataAsset::UnbindCurveTableChanged()
+{
+	if (UCurveTable* CurveTable = BoundCurveTable.Get())
+	{
+		CurveTable->OnCurveTableChanged().Remove(CurveTableChangedHandle);
+	}
+	BoundCurveTable.Reset();
+	CurveTableChangedHandle.Reset();
+}
+#endif
+
+void UCharacterClassInfoDataAsset::BakeDamageCoefficients()
+{
+	for (TArray<float>& BakedCoefficients : BakedDamageCoefficients)
+	{
+		BakedCoefficients.Reset();
+	}
+
+	if (DamageCalculationCoefficients == nullptr) return;
+
+	// The curve table may not have finished loading yet when we get here from PostLoad.
+	DamageCalculationCoefficients->ConditionalPostLoad();
+
+	for (uint8 CoefficientIndex = 0; CoefficientIndex < static_cast<uint8>(EDamageCoefficient::MAX); ++CoefficientIndex)
+	{
+		const FName RowName = GetDamageCoefficientRowName(CoefficientIndex);
+		const FRealCurve* Curve = DamageCalculationCoefficients->FindCurve(RowName, GetName(), false);
+		if (Curve == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s: No curve named %s in %s, damage coefficient will not be baked."), *GetName(), *RowName.ToString(), *DamageCalculationCoefficients->GetName());
+			continue;
+		}
+
+		TArray<float>& BakedCoefficients = BakedDamageCoefficients[CoefficientIndex];
+		BakedCoefficients.SetNumUninitialized(MaxBakedCoefficientLevel + 1);
+		for (int32 Level = 0; Level <= MaxBakedCoefficientLevel; ++Level)
+		{
+			BakedCoefficients[Level] = Curve->Eval(Level);
+		}
+	}
+}
+
+float UCharacterClassInfoDataAsset::EvaluateDamageCoefficientCurve(EDamageCoefficient Coefficient, int32 Level) const
+{
+	if (DamageCalculationCoefficients == nullptr) return 0.f;
+	
+	// A missing curve was already reported when baking, so this path stays quiet.
+	const FRealCurve* Curve = DamageCalculationCoefficients->FindCurve(GetDamageCoefficientRowName(static_cast<uint8>(Coefficient)), FString(), false);
+	return Curve ? Curve->Eval(Level) : 0.f;
+}
@@ -8,7 +8,13 @@
 #include "TopDownGameplayTags.h"
 #include "AbilitySystem/BaseAttributeSet.h"
 #include "AbilitySystem/TopDownAbilitySystemLibrary.h"
+#include "AbilitySystem/Data/CharacterClassInfoDataAsset.h"
 #include "Interface/Interaction/CombatInterface.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+#include "Subsystem/TopDownCombatLogSubsystem.h"
+#include "Subsystem/TopDownCombatSimulationSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("ExecCalc Damage"), STAT_ExecCalcDamage, STATGROUP_TopDown);
 
 struct TopDownDamageStatics
 {
@@ -55,16 +61,30 @@ UExecCalc_Damage::UExecCalc_Damage()
 void UExecCalc_Damage::Execute_Implementation(const FGameplayEffectCustomExecutionParameters& ExecutionParams,
 	FGameplayEffectCustomExecutionOutput& OutExecutionOutput) const
 {
+	SCOPE_CYCLE_COUNTER(STAT_ExecCalcDamage);
+
+	// Damage resolved up front by UTopDownAbilitySystemLibrary::ApplyDamageEffectSpecToTargets, which also set the context flags and logged the hit.
+	const float ResolvedDamage = ExecutionParams.GetOwningSpec().GetSetByCallerMagnitude(FTopDownGameplayTags::Get().Damage_Resolved, false, -1.f);
+	if (ResolvedDamage >= 0.f)
+	{
+		OutExecutionOutput.AddOutputModifier(FGameplayModifierEvaluatedData(UBaseAttributeSet::GetIncomingDamageAttribute(), EGameplayModOp::Additive, ResolvedDamage));
+		return;
+	}
+	
+	TOPDOWN_COMBAT_SIMULATION_SCOPE_EXEC_CALC();
+	
 	const UAbilitySystemComponent* SourceAbilitySystemComponent = ExecutionParams.GetSourceAbilitySystemComponent();
 	const UAbilitySystemComponent* TargetAbilitySystemComponent = ExecutionParams.GetTargetAbilitySystemComponent();
 
 	AActor* SourceAvatarActor = SourceAbilitySystemComponent ? SourceAbilitySystemComponent->GetAvatarActor() : nullptr;
 	ICombatInterface* SourceCombatInterface = Cast<ICombatInterface>(SourceAvatarActor);
-	const UCharacterClassInfoDataAsset* SourceCharacterClassInfoDataAsset = UTopDownAbilitySystemLibrary::GetCharacterClassInfoDataAsset(SourceAvatarActor);
 	
 	AActor* TargetAvatarActor = TargetAbilitySystemComponent ? TargetAbilitySystemComponent->GetAvatarActor() : nullptr;
 	ICombatInterface* TargetCombatInterface = Cast<ICombatInterface>(TargetAvatarActor);
-	const UCharacterClassInfoDataAsset* TargetCharacterClassInfoDataAsset = UTopDownAbilitySystemLibrary::GetCharacterClassInfoDataAsset(TargetAvatarActor);
+
+	// Source and target share the game mode's data asset, so it is only fetched once.
+	const UCharacterClassInfoDataAsset* CharacterClassInfoDataAsset = UTopDownAbilitySystemLibrary::GetCharacterClassInfoDataAsset(SourceAvatarActor);
+	check(CharacterClassInfoDataAsset);
 	
 	const FGameplayEffectSpec GameplayEffectSpec = ExecutionParams.GetOwningSpec();
 	FGameplayEffectContextHandle GameplayEffectContextHandle = GameplayEffectSpec.GetContext();
@@ -77,7 +97,7 @@ void UExecCalc_Damage::Execute_Implementation(const FGameplayEffectCustomExecuti
 	EvaluationParameters.TargetTags = TargetTags;
 
 	// Get Damage Set by Caller Magnitude
-	float Damage = GameplayEffectSpec.GetSetByCallerMagnitude(FTopDownGameplayTags::Get().Damage);
+	const float Damage = GameplayEffectSpec.GetSetByCallerMagnitude(FTopDownGameplayTags::Get().Damage);
 
 	// Armor penetration ignores a percentage of the target's armor
 	float TargetArmor = 0.f;
@@ -99,7 +119,7 @@ void UExecCalc_Damage::Execute_Implementation(const FGameplayEffectCustomExecuti
 	float TargetBlockChance = 0.f;
 	// We are getting the block chance value from the target
 	ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().BlockChanceDef, EvaluationParameters, TargetBlockChance);
-	SourceArmorPenetration = FMath::Max<float>(TargetBlockChance, 0.f);
+	TargetBlockChance = FMath::Max<float>(TargetBlockChance, 0.f);
 
 	float SourceCriticalHitChance = 0.f;
 	// We are getting the critical hit chance value from the source
@@ -122,39 +142,100 @@ void UExecCalc_Damage::Execute_Implementation(const FGameplayEffectCustomExecuti
 	ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().EvasionDef, EvaluationParameters, TargetEvasion);
 	TargetEvasion = FMath::Max<float>(TargetEvasion, 0.f);
 
-	const bool bEvaded = FMath::FRandRange(UE_SMALL_NUMBER, 100.f) <= TargetEvasion;
-	UTopDownAbilitySystemLibrary::SetIsEvaded(GameplayEffectContextHandle, bEvaded);
-	// if Target evades the attack, zero damage.
-	Damage = bEvaded ? Damage = 0.f : Damage;
+	FTopDownDamageSourceParams SourceParams;
+	SourceParams.Damage = Damage;
+	SourceParams.ArmorPenetration = SourceArmorPenetration;
+	SourceParams.CriticalHitChance = SourceCriticalHitChance;
+	SourceParams.CriticalHitDamage = SourceCriticalHitDamage;
+	SourceParams.ArmorPenetrationCoefficient = CharacterClassInfoDataAsset->GetDamageCoefficient(EDamageCoefficient::ArmorPenetration, SourceCombatInterface->GetCharacterLevel());
+
+	const int32 TargetLevel = TargetCombatInterface->GetCharacterLevel();
+	FTopDownDamageTargetParams TargetParams;
+	TargetParams.Armor = TargetArmor;
+	TargetParams.BlockChance = TargetBlockChance;
+	TargetParams.CriticalHitResistance = TargetCriticalHitResistance;
+	TargetParams.Evasion = TargetEvasion;
+	TargetParams.EffectiveArmorCoefficient = CharacterClassInfoDataAsset->GetDamageCoefficient(EDamageCoefficient::EffectiveArmor, TargetLevel);
+	TargetParams.CriticalHitResistanceCoefficient = CharacterClassInfoDataAsset->GetDamageCoefficient(EDamageCoefficient::CriticalHitResistance, TargetLevel);
+
+	const FTopDownDamageResult DamageResult = ResolveDamage(SourceParams, TargetParams);
+	UTopDownAbilitySystemLibrary::SetIsEvaded(GameplayEffectContextHandle, DamageResult.bEvaded);
+	UTopDownAbilitySystemLibrary::SetIsBlockedHit(GameplayEffectContextHandle, DamageResult.bBlocked);
+	UTopDownAbilitySystemLibrary::SetIsCriticalHit(GameplayEffectContextHandle, DamageResult.bCriticalHit);
+
+	if (UTopDownCombatLogSubsystem* CombatLog = UTopDownCombatLogSubsystem::Get(TargetAvatarActor))
+	{
+		CombatLog->RecordDamage(ETopDownCombatEventType::DamageResolved, SourceAvatarActor, TargetAvatarActor, Damage, DamageResult.Damage,
+			UTopDownCombatLogSubsystem::MakeDamageFlags(DamageResult.bEvaded, DamageResult.bBlocked, DamageResult.bCriticalHit));
+	}
 	
-	const FRealCurve* ArmorPenetrationCurve = SourceCharacterClassInfoDataAsset->DamageCalculationCoefficients->FindCurve(FName("ArmorPenetration"), FString());
-	const float ArmorPenetrationCoefficient = ArmorPenetrationCurve->Eval(SourceCombatInterface->GetCharacterLevel());
+	const FGameplayModifierEvaluatedData EvaluatedData(UBaseAttributeSet::GetIncomingDamageAttribute(), EGameplayModOp::Additive, DamageResult.Damage);
+	OutExecutionOutput.AddOutputModifier(EvaluatedData);
+}
 
-	// Target Armor after Armor Penetration applied.
-	const float EffectiveArmor = TargetArmor * (100 - SourceArmorPenetration * ArmorPenetrationCoefficient) / 100.f;
+static float CaptureAttributeFromAbilitySystemComponent(UAbilitySystemComponent* AbilitySystemComponent, const FGameplayEffectAttributeCaptureDefinition& CaptureDefinition,
+	const FAggregatorEvaluateParameters& EvaluationParameters)
+{
+	FGameplayEffectAttributeCaptureSpec CaptureSpec(CaptureDefinition);
+	AbilitySystemComponent->CaptureAttributeForGameplayEffect(CaptureSpec);
+	float Magnitude = 0.f;
+	CaptureSpec.AttemptCalculateAttributeMagnitude(EvaluationParameters, Magnitude);
+	return FMath::Max<float>(Magnitude, 0.f);
+}
+
+static float CaptureSourceAttribute(const FGameplayEffectSpec& Spec, const FGameplayEffectAttributeCaptureDefinition& CaptureDefinition,
+	const FAggregatorEvaluateParameters& EvaluationParameters)
+{
+	if (const FGameplayEffectAttributeCaptureSpec* CaptureSpec = Spec.CapturedRelevantAttributes.FindCaptureSpecByDefinition(CaptureDefinition, true))
+	{
+		float Magnitude = 0.f;
+		CaptureSpec->AttemptCalculateAttributeMagnitude(EvaluationParameters, Magnitude);
+		return FMath::Max<float>(Magnitude, 0.f);
+	}
+	// The spec's effect does not run this execution, so nothing was captured when it was made.
+	UAbilitySystemComponent* SourceAbilitySystemComponent = Spec.GetContext().GetInstigatorAbilitySystemComponent();
+	return SourceAbilitySystemComponent ? CaptureAttributeFromAbilitySystemComponent(SourceAbilitySystemComponent, CaptureDefinition, EvaluationParameters) : 0.f;
+}
+
+void UExecCalc_Damage::CaptureSourceAttributes(const FGameplayEffectSpec& Spec, const FAggregatorEvaluateParameters& EvaluationParameters, FTopDownDamageSourceParams& OutSource)
+{
+	OutSource.ArmorPenetration = CaptureSourceAttribute(Spec, DamageStatics().ArmorPenetrationDef, EvaluationParameters);
+	OutSource.CriticalHitChance = CaptureSourceAttribute(Spec, DamageStatics().CriticalHitChanceDef, EvaluationParameters);
+	OutSource.CriticalHitDamage = CaptureSourceAttribute(Spec, DamageStatics().CriticalHitDamageDef, EvaluationParameters);
+}
+
+void UExecCalc_Damage::CaptureTargetAttributes(UAbilitySystemComponent* TargetAbilitySystemComponent, const FAggregatorEvaluateParameters& EvaluationParameters, FTopDownDamageTargetParams& OutTarget)
+{
+	OutTarget.Armor = CaptureAttributeFromAbilitySystemComponent(TargetAbilitySystemComponent, DamageStatics().ArmorDef, EvaluationParameters);
+	OutTarget.BlockChance = CaptureAttributeFromAbilitySystemComponent(TargetAbilitySystemComponent, DamageStatics().BlockChanceDef, EvaluationParameters);
+	OutTarget.CriticalHitResistance = CaptureAttributeFromAbilitySystemComponent(TargetAbilitySystemComponent, DamageStatics().CriticalHitResistanceDef, EvaluationParameters);
+	OutTarget.Evasion = CaptureAttributeFromAbilitySystemComponent(TargetAbilitySystemComponent, DamageStatics().EvasionDef, EvaluationParameters);
+}
+
+FTopDownDamageResult UExecCalc_Damage::ResolveDamage(const FTopDownDamageSourceParams& Source, const FTopDownDamageTargetParams& Target)
+{
+	FTopDownDamageResult Result;
+	float Damage = Source.Damage;
 	
-	const FRealCurve* EffectiveArmorCurve = TargetCharacterClassInfoDataAsset->DamageCalculationCoefficients->FindCurve(FName("EffectiveArmor"), FString());
-	const float EffectiveArmorCoefficient = EffectiveArmorCurve->Eval(TargetCombatInterface->GetCharacterLevel());
+	Result.bEvaded = FMath::FRandRange(UE_SMALL_NUMBER, 100.f) <= Target.Evasion;
+	// if Target evades the attack, zero damage.
+	Damage = Result.bEvaded ? 0.f : Damage;
+
+	// Target Armor after Armor Penetration applied.
+	const float EffectiveArmor = Target.Armor * (100 - Source.ArmorPenetration * Source.ArmorPenetrationCoefficient) / 100.f;
 
 	// Armor ignores a percentage of incoming Damage
-	Damage *= (100 - EffectiveArmor * EffectiveArmorCoefficient) / 100.f;
+	Damage *= (100 - EffectiveArmor * Target.EffectiveArmorCoefficient) / 100.f;
 	
-	const bool bBlocked = FMath::FRandRange(UE_SMALL_NUMBER, 100.f) < TargetBlockChance;
-	UTopDownAbilitySystemLibrary::SetIsBlockedHit(GameplayEffectContextHandle, bBlocked);
+	Result.bBlocked = FMath::FRandRange(UE_SMALL_NUMBER, 100.f) < Target.BlockChance;
 	// If Block, halve the damage.	
-	Damage = bBlocked ? Damage / 2.f : Damage;
-	
-	const FRealCurve* CriticalHitResistanceCurve = TargetCharacterClassInfoDataAsset->DamageCalculationCoefficients->FindCurve(FName("CriticalHitResistance"), FString());
-	const float CriticalHitResistanceCoefficient = CriticalHitResistanceCurve->Eval(TargetCombatInterface->GetCharacterLevel());
+	Damage = Result.bBlocked ? Damage / 2.f : Damage;
 
 	// Critical Hit Resistance reduces Critical Hit Chance by a certain percentage
-	const float EffectiveCriticalHitChance = SourceCriticalHitChance - TargetCriticalHitResistance * CriticalHitResistanceCoefficient;
-	const bool bCriticalHitChance = FMath::FRandRange(UE_SMALL_NUMBER, 100.f) <= EffectiveCriticalHitChance;
-	UTopDownAbilitySystemLibrary::SetIsCriticalHit(GameplayEffectContextHandle, bCriticalHitChance);
+	const float EffectiveCriticalHitChance = Source.CriticalHitChance - Target.CriticalHitResistance * Target.CriticalHitResistanceCoefficient;
+	Result.bCriticalHit = FMath::FRandRange(UE_SMALL_NUMBER, 100.f) <= EffectiveCriticalHitChance;
 
 	// Double damage plus a bonus if critical hit
-	Damage = bCriticalHitChance ? 2.f * Damage + SourceCriticalHitDamage : Damage;
-	
-	const FGameplayModifierEvaluatedData EvaluatedData(UBaseAttributeSet::GetIncomingDamageAttribute(), EGameplayModOp::Additive, Damage);
-	OutExecutionOutput.AddOutputModifier(EvaluatedData);
+	Result.Damage = Result.bCriticalHit ? 2.f * Damage + Source.CriticalHitDamage : Damage;
+	return Result;
 }
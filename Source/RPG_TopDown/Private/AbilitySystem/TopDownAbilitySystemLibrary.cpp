@@ -3,17 +3,122 @@
 
 #include "AbilitySystem/TopDownAbilitySystemLibrary.h"
 
+#include "AbilitySystemBlueprintLibrary.h"
 #include "AbilitySystemComponent.h"
+#include "TopDownGameplayTags.h"
+#include "AbilitySystem/BaseAttributeSet.h"
+#include "AbilitySystem/ExecutionCalculation/ExecCalc_Damage.h"
 #include "Controller/Widget/AttributeMenuWidgetController.h"
+#include "Character/EnemyCharacter.h"
 #include "Controller/Widget/BaseWidgetController.h"
 #include "Game/TopDownGameModeBase.h"
+#include "Interface/Interaction/CombatInterface.h"
 #include "Kismet/GameplayStatics.h"
 #include "PlayerState/TopDownPlayerState.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+#include "Subsystem/TopDownCombatLogSubsystem.h"
+#include "Subsystem/TopDownCombatSimulationSubsystem.h"
 #include "UI/HUD/TopDownHUD.h"
 
+DECLARE_CYCLE_STAT(TEXT("Batched Damage"), STAT_BatchedDamage, STATGROUP_TopDown);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Batched Damage Targets"), STAT_BatchedDamageTargets, STATGROUP_TopDown);
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithWorldAndArgs CDamageBenchmark(
+	TEXT("TopDown.Damage.Benchmark"),
+	TEXT("Spawns <Count> (default 100) enemies and times damaging all of them with one spec, once applied per target and once through ApplyDamageEffectSpecToTargets.\n")
+	TEXT("Count=<n> Damage=<n> EnemyClass=<path> Effect=<path>. Server only."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr || World->GetNetMode() == NM_Client) return;
+
+		const FString Cmd = FString::Join(Args, TEXT(" "));
+		int32 Count = 100;
+		float Damage = 1.f;
+		FParse::Value(*Cmd, TEXT("Count="), Count);
+		FParse::Value(*Cmd, TEXT("Damage="), Damage);
+		Count = FMath::Max(Count, 1);
+		constexpr int32 Passes = 10;
+
+		FString ClassPath = TEXT("/Game/Blueprints/Characters/Enemy/Goblin_Spear/BP_Goblin_Spear.BP_Goblin_Spear_C");
+		FParse::Value(*Cmd, TEXT("EnemyClass="), ClassPath);
+		UClass* EnemyClass = FSoftClassPath(ClassPath).TryLoadClass<AEnemyCharacter>();
+		ClassPath = TEXT("/Game/Blueprints/AbilitySystem/GameplayEffects/GE_Damage.GE_Damage_C");
+		FParse::Value(*Cmd, TEXT("Effect="), ClassPath);
+		UClass* EffectClass = FSoftClassPath(ClassPath).TryLoadClass<UGameplayEffect>();
+		if (EnemyClass == nullptr || EffectClass == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Damage benchmark could not load the enemy class or the damage effect."));
+			return;
+		}
+
+		// The first enemy is the source, the others are the targets. Everything runs within this frame, so they never move.
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		TArray<AActor*> Enemies;
+		for (int32 Index = 0; Index <= Count; ++Index)
+		{
+			if (AEnemyCharacter* Enemy = World->SpawnActor<AEnemyCharacter>(EnemyClass, FVector(Index * 100.f, 0.f, 0.f), FRotator::ZeroRotator, SpawnParameters))
+			{
+				Enemies.Add(Enemy);
+			}
+		}
+		UAbilitySystemComponent* SourceAbilitySystemComponent = Enemies.Num() > 1 ? UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Enemies[0]) : nullptr;
+		if (SourceAbilitySystemComponent)
+		{
+			const TArray<AActor*> Targets(Enemies.GetData() + 1, Enemies.Num() - 1);
+			const FGameplayEffectSpecHandle DamageEffectSpecHandle = SourceAbilitySystemComponent->MakeOutgoingSpec(EffectClass, 1.f, SourceAbilitySystemComponent->MakeEffectContext());
+			UAbilitySystemBlueprintLibrary::AssignTagSetByCallerMagnitude(DamageEffectSpecHandle, FTopDownGameplayTags::Get().Damage, Damage);
+
+			// Nobody may die halfway through, so every pass starts from full health.
+			auto RestoreHealth = [&Targets]()
+			{
+				for (AActor* Target : Targets)
+				{
+					UAbilitySystemComponent* TargetAbilitySystemComponent = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Target);
+					TargetAbilitySystemComponent->SetNumericAttributeBase(UBaseAttributeSet::GetHealthAttribute(), TargetAbilitySystemComponent->GetNumericAttribute(UBaseAttributeSet::GetMaxHealthAttribute()));
+				}
+			};
+
+			double PerTargetSeconds = 0.0;
+			for (int32 Pass = 0; Pass < Passes; ++Pass)
+			{
+				RestoreHealth();
+				const double Start = FPlatformTime::Seconds();
+				for (AActor* Target : Targets)
+				{
+					SourceAbilitySystemComponent->ApplyGameplayEffectSpecToTarget(*DamageEffectSpecHandle.Data.Get(), UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Target));
+				}
+				PerTargetSeconds += FPlatformTime::Seconds() - Start;
+			}
+
+			double BatchedSeconds = 0.0;
+			for (int32 Pass = 0; Pass < Passes; ++Pass)
+			{
+				RestoreHealth();
+				const double Start = FPlatformTime::Seconds();
+				UTopDownAbilitySystemLibrary::ApplyDamageEffectSpecToTargets(DamageEffectSpecHandle, Targets);
+				BatchedSeconds += FPlatformTime::Seconds() - Start;
+			}
+
+			UE_LOG(LogTemp, Display, TEXT("Damage benchmark, %d targets, %d passes, %s"), Targets.Num(), Passes, *EffectClass->GetName());
+			UE_LOG(LogTemp, Display, TEXT("  Per target: %.4f ms per pass"), PerTargetSeconds * 1000.0 / Passes);
+			UE_LOG(LogTemp, Display, TEXT("  Batched:    %.4f ms per pass"), BatchedSeconds * 1000.0 / Passes);
+		}
+
+		for (AActor* Enemy : Enemies)
+		{
+			Enemy->Destroy();
+		}
+	}));
+
+#endif
+
 // Retrieves the overlay widget controller from the HUD associated with the player controller.
 UOverlayWidgetController* UTopDownAbilitySystemLibrary::GetOverlayWidgetController(const UObject* WorldContextObject)
 {
+#if TOPDOWN_WITH_COSMETICS
 	// Get the first player controller in the world
 	APlayerController* PC = WorldContextObject->GetWorld()->GetFirstPlayerController();
 	if (PC)
@@ -31,6 +136,7 @@ UOverlayWidgetController* UTopDownAbilitySystemLibrary::GetOverlayWidgetControll
 			return TopDownHUD->GetOverlayWidgetController(WidgetControllerVariables);
 		}
 	}
+#endif
 	return nullptr;
 }
 
@@ -38,6 +144,7 @@ UOverlayWidgetController* UTopDownAbilitySystemLibrary::GetOverlayWidgetControll
 // Retrieves the attribute menu widget controller from the HUD associated with the player controller.
 UAttributeMenuWidgetController* UTopDownAbilitySystemLibrary::GetAttributeMenuWidgetController(const UObject* WorldContextObject)
 {
+#if TOPDOWN_WITH_COSMETICS
 	// Get the first player controller in the world
 	APlayerController* PC = WorldContextObject->GetWorld()->GetFirstPlayerController();
 	if (PC)
@@ -55,6 +162,7 @@ UAttributeMenuWidgetController* UTopDownAbilitySystemLibrary::GetAttributeMenuWi
 			return TopDownHUD->GetAttributeMenuWidgetController(WidgetControllerVariables);
 		}
 	}
+#endif
 	return nullptr;
 }
 
@@ -173,3 +281,91 @@ void UTopDownAbilitySystemLibrary::SetIsBlockedHit(FGameplayEffectContextHandle&
 		TopDownGameplayEffectContext->SetIsBlockedHit(bInIsBlockedHit);
 	}
 }
+
+void UTopDownAbilitySystemLibrary::ApplyDamageEffectSpecToTargets(const FGameplayEffectSpecHandle& DamageEffectSpecHandle, const TArray<AActor*>& TargetActors)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BatchedDamage);
+	TOPDOWN_COMBAT_SIMULATION_SCOPE_EXEC_CALC();
+	
+	const FGameplayEffectSpec* DamageEffectSpec = DamageEffectSpecHandle.Data.Get();
+	if (DamageEffectSpec == nullptr || TargetActors.IsEmpty()) return;
+
+	const FGameplayEffectContextHandle& SourceContextHandle = DamageEffectSpec->GetContext();
+	UAbilitySystemComponent* SourceAbilitySystemComponent = SourceContextHandle.GetInstigatorAbilitySystemComponent();
+	if (SourceAbilitySystemComponent == nullptr) return;
+
+	AActor* SourceAvatarActor = SourceAbilitySystemComponent->GetAvatarActor();
+	ICombatInterface* SourceCombatInterface = Cast<ICombatInterface>(SourceAvatarActor);
+	const UCharacterClassInfoDataAsset* CharacterClassInfoDataAsset = GetCharacterClassInfoDataAsset(SourceAvatarActor);
+	if (SourceCombatInterface == nullptr || CharacterClassInfoDataAsset == nullptr) return;
+
+	// Capture the source side once for the whole batch, from the captures the spec took when it was made, like UExecCalc_Damage does.
+	FAggregatorEvaluateParameters EvaluationParameters;
+	EvaluationParameters.SourceTags = DamageEffectSpec->CapturedSourceTags.GetAggregatedTags();
+	
+	FTopDownDamageSourceParams SourceParams;
+	SourceParams.Damage = DamageEffectSpec->GetSetByCallerMagnitude(FTopDownGameplayTags::Get().Damage);
+	UExecCalc_Damage::CaptureSourceAttributes(*DamageEffectSpec, EvaluationParameters, SourceParams);
+	SourceParams.ArmorPenetrationCoefficient = CharacterClassInfoDataAsset->GetDamageCoefficient(EDamageCoefficient::ArmorPenetration, SourceCombatInterface->GetCharacterLevel());
+
+	// Gather the target side into contiguous arrays. Each target is captured with its own tags, as applying the spec to it would.
+	TArray<UAbilitySystemComponent*, TInlineAllocator<32>> TargetAbilitySystemComponents;
+	TArray<FTopDownDamageTargetParams, TInlineAllocator<32>> TargetParams;
+	TargetAbilitySystemComponents.Reserve(TargetActors.Num());
+	TargetParams.Reserve(TargetActors.Num());
+	FGameplayTagContainer TargetTags;
+	EvaluationParameters.TargetTags = &TargetTags;
+	for (AActor* TargetActor : TargetActors)
+	{
+		UAbilitySystemComponent* TargetAbilitySystemComponent = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(TargetActor);
+		ICombatInterface* TargetCombatInterface = Cast<ICombatInterface>(TargetActor);
+		if (TargetAbilitySystemComponent == nullptr || TargetCombatInterface == nullptr) continue;
+
+		TargetTags.Reset();
+		TargetAbilitySystemComponent->GetOwnedGameplayTags(TargetTags);
+		
+		const int32 TargetLevel = TargetCombatInterface->GetCharacterLevel();
+		FTopDownDamageTargetParams& Params = TargetParams.AddDefaulted_GetRef();
+		UExecCalc_Damage::CaptureTargetAttributes(TargetAbilitySystemComponent, EvaluationParameters, Params);
+		Params.EffectiveArmorCoefficient = CharacterClassInfoDataAsset->GetDamageCoefficient(EDamageCoefficient::EffectiveArmor, TargetLevel);
+		Params.CriticalHitResistanceCoefficient = CharacterClassInfoDataAsset->GetDamageCoefficient(EDamageCoefficient::CriticalHitResistance, TargetLevel);
+		TargetAbilitySystemComponents.Add(TargetAbilitySystemComponent);
+	}
+	INC_DWORD_STAT_BY(STAT_BatchedDamageTargets, TargetParams.Num());
+
+	// Resolve mitigation for every target in one pass.
+	TArray<FTopDownDamageResult, TInlineAllocator<32>> Results;
+	Results.SetNumUninitialized(TargetParams.Num());
+	for (int32 Index = 0; Index < TargetParams.Num(); ++Index)
+	{
+		Results[Index] = UExecCalc_Damage::ResolveDamage(SourceParams, TargetParams[Index]);
+	}
+
+	/*
+	 * Commit the caller's own effect to each target, so its cues, granted tags and other modifiers still apply.
+	 * The Damage.Resolved set by caller magnitude makes UExecCalc_Damage output the resolved damage instead of resolving it again.
+	 * Each target gets its own context so the evaded, blocked and critical hit flags reach PostGameplayEffectExecute.
+	 */
+	const FGameplayTag DamageResolvedTag = FTopDownGameplayTags::Get().Damage_Resolved;
+	UTopDownCombatLogSubsystem* CombatLog = UTopDownCombatLogSubsystem::Get(SourceAvatarActor);
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		const FTopDownDamageResult& Result = Results[Index];
+		
+		FGameplayEffectContextHandle TargetContextHandle = SourceContextHandle.Duplicate();
+		SetIsEvaded(TargetContextHandle, Result.bEvaded);
+		SetIsBlockedHit(TargetContextHandle, Result.bBlocked);
+		SetIsCriticalHit(TargetContextHandle, Result.bCriticalHit);
+
+		if (CombatLog)
+		{
+			CombatLog->RecordDamage(ETopDownCombatEventType::DamageResolved, SourceAvatarActor, TargetAbilitySystemComponents[Index]->GetAvatarActor(),
+				SourceParams.Damage, Result.Damage, UTopDownCombatLogSubsystem::MakeDamageFlags(Result.bEvaded, Result.bBlocked, Result.bCriticalHit));
+		}
+
+		FGameplayEffectSpec CommitSpec(*DamageEffectSpec);
+		CommitSpec.SetContext(TargetContextHandle, true);
+		CommitSpec.SetSetByCallerMagnitude(DamageResolvedTag, Result.Damage);
+		SourceAbilitySystemComponent->ApplyGameplayEffectSpecToTarget(CommitSpec, TargetAbilitySystemComponents[Index]);
+	}
+}
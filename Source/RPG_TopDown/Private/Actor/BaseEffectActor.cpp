@@ -5,6 +5,7 @@
 
 #include "AbilitySystemBlueprintLibrary.h"
 #include "AbilitySystemComponent.h"
+#include "TopDownCombatTrace.h"
 
 // Sets default values
 ABaseEffectActor::ABaseEffectActor()
@@ -91,12 +92,8 @@ void ABaseEffectActor::ApplyGameplayEffectToTarget(AActor* Target, const FApplie
 	// If true, Destroys actor on effect application.
 	if (bDestroyActorOnEffectApplication) Destroy();
 
-	/*
-	 * DEBUG: Count the active gameplay effects
-	 */
-	const int EffectCount = TargetAbilitySystemComponent->GetGameplayEffectCount(AppliedGameplayEffectProperties.GameplayEffectClass, TargetAbilitySystemComponent);
-	const FString ClassName = AppliedGameplayEffectProperties.GameplayEffectClass->GetName();
-	//GEngine->AddOnScreenDebugMessage(-1, 15.f, FColor::Green, FString::Printf(TEXT("Active Effect Name and Count: %s and %d"), *ClassName, EffectCount));
+	// Active effect count for Insights, only looked up while the combat trace channel is recording.
+	TOPDOWN_TRACE_GAMEPLAY_EFFECT_CHANGED(TargetAbilitySystemComponent, AppliedGameplayEffectProperties.GameplayEffectClass, false);
 }
 
 void ABaseEffectActor::RemoveGameplayEffectFromTarget(AActor* TargetActor, const FAppliedGameplayEffectProperties& AppliedGameplayEffectProperties)
@@ -110,12 +107,7 @@ void ABaseEffectActor::RemoveGameplayEffectFromTarget(AActor* TargetActor, const
 	// If true, Destroys actor on effect removal.
 	if (bDestroyActorOnEffectRemoval) Destroy();
 
-	/*
-	 * DEBUG: Count the active gameplay effects
-	 */
-	const int EffectCount = TargetAbilitySystemComponent->GetGameplayEffectCount(AppliedGameplayEffectProperties.GameplayEffectClass, TargetAbilitySystemComponent);
-	const FString ClassName = AppliedGameplayEffectProperties.GameplayEffectClass->GetName();
-	//GEngine->AddOnScreenDebugMessage(-1, 15.f, FColor::Red, FString::Printf(TEXT("Active Effect Name and Count: %s and %d"), *ClassName, EffectCount));
+	TOPDOWN_TRACE_GAMEPLAY_EFFECT_CHANGED(TargetAbilitySystemComponent, AppliedGameplayEffectProperties.GameplayEffectClass, true);
 }
 
 void ABaseEffectActor::ApplyAllGameplayEffects(AActor* TargetActor, const EEffectApplicationPolicy& EffectApplicationPolicy)
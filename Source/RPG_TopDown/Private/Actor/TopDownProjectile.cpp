@@ -6,10 +6,15 @@
 #include "AbilitySystemBlueprintLibrary.h"
 #include "AbilitySystemComponent.h"
 #include "NiagaraFunctionLibrary.h"
+#include "AbilitySystem/TopDownAbilitySystemLibrary.h"
 #include "Components/AudioComponent.h"
 #include "Components/SphereComponent.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+#include "Subsystem/TopDownProjectilePoolSubsystem.h"
+#include "Subsystem/TopDownSpatialGridSubsystem.h"
 
 ATopDownProjectile::ATopDownProjectile()
 {
@@ -31,36 +36,56 @@ ATopDownProjectile::ATopDownProjectile()
 	ProjectileMovementComponent->bRotationFollowsVelocity = true;
 }
 
+void ATopDownProjectile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ATopDownProjectile, PooledState);
+}
+
 void ATopDownProjectile::BeginPlay()
 {
 	Super::BeginPlay();
 
+	Sphere->OnComponentBeginOverlap.AddDynamic(this, &ATopDownProjectile::OnSphereOverlap);
+
+	if (PooledState.bPooled)
+	{
+		// On the server the pool launches or parks the projectile right after spawning it. Clients follow the replicated state.
+		if (!HasAuthority())
+		{
+			if (PooledState.bActive)
+			{
+				LocalLaunchCount = PooledState.LaunchCount;
+				StartFlight(PooledState.LaunchLocation, PooledState.LaunchRotation);
+			}
+			else
+			{
+				StopFlight();
+			}
+		}
+		return;
+	}
+
+	bInFlight = true;
+	
 	// Configures the collision sphere to ignore the instigator (the actor that spawned the projectile).
 	Sphere->IgnoreActorWhenMoving(GetInstigator(), true);
 
 	SetLifeSpan(LifeSpan);
-	
-	Sphere->OnComponentBeginOverlap.AddDynamic(this, &ATopDownProjectile::OnSphereOverlap);
 
+#if TOPDOWN_WITH_COSMETICS
 	ensure(LoopingEffectSound);
 	const EAttachLocation::Type AttachLocationType = EAttachLocation::KeepWorldPosition;
 	LoopingEffectAudioComponent = UGameplayStatics::SpawnSoundAttached(LoopingEffectSound, Sphere, FName(), GetActorLocation(), FRotator().ZeroRotator, AttachLocationType);
+#endif
 }
 
 void ATopDownProjectile::Destroyed()
 {
-	if (!bCollisionHit && !HasAuthority())
+	if (!bCollisionHit && bInFlight && !HasAuthority())
 	{
-		ensure(ImpactSound);
-		UGameplayStatics::PlaySoundAtLocation(this, ImpactSound, GetActorLocation(), FRotator().ZeroRotator);
-		ensure(ImpactEffect);
-		UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, ImpactEffect, GetActorLocation());
-		
-		if (LoopingEffectAudioComponent)
-		{
-			// WARNING: nullptr error on dedicated server.
-			LoopingEffectAudioComponent->Stop();
-		}
+		PlayImpactEffects();
 	}
 	Super::Destroyed();
 }
@@ -68,23 +93,28 @@ void ATopDownProjectile::Destroyed()
 void ATopDownProjectile::OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
                                          UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
-	ensure(ImpactSound);
-	UGameplayStatics::PlaySoundAtLocation(this, ImpactSound, GetActorLocation(), FRotator().ZeroRotator);
-	ensure(ImpactEffect);
-	UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, ImpactEffect, GetActorLocation());
+	if (!bInFlight) return;
 	
-	if (LoopingEffectAudioComponent)
-	{
-		// WARNING: nullptr error on dedicated server.
-		LoopingEffectAudioComponent->Stop();
-	}
+	PlayImpactEffects();
 	
 	if (HasAuthority())
 	{
 		// Now Applying Gameplay Effect is something we should do on the server only as we don't need to do this on clients.
 		// The effect is going to change an attribute and the attribute itself is replicated.
 		// So the end result, the changing of the attribute that will be replicated.
-		if (UAbilitySystemComponent* TargetAbilitySystemComponent = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(OtherActor))
+		if (ImpactDamageRadius > 0.f)
+		{
+			// Area damage: the mitigation of everyone around the impact is resolved in one pass.
+			TArray<AActor*> TargetActors;
+			if (const UTopDownSpatialGridSubsystem* SpatialGrid = GetWorld()->GetSubsystem<UTopDownSpatialGridSubsystem>())
+			{
+				SpatialGrid->QueryRadius(GetActorLocation(), ImpactDamageRadius, TargetActors);
+			}
+			TargetActors.AddUnique(OtherActor);
+			TargetActors.Remove(GetInstigator());
+			UTopDownAbilitySystemLibrary::ApplyDamageEffectSpecToTargets(DamageEffectSpecHandle, TargetActors);
+		}
+		else if (UAbilitySystemComponent* TargetAbilitySystemComponent = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(OtherActor))
 		{
 			/*
 			 * ApplyGameplayEffectSpecToSelf requires a GameplayEffectSpec. DamageEffectSpecHandle is an effect spec handle.
@@ -95,7 +125,7 @@ void ATopDownProjectile::OnSphereOverlap(UPrimitiveComponent* OverlappedComponen
 			TargetAbilitySystemComponent->ApplyGameplayEffectSpecToSelf(*DamageEffectSpecHandle.Data.Get());
 		}
 		
-		Destroy();
+		EndProjectile();
 	}
 	else
 	{
@@ -103,3 +133,130 @@ void ATopDownProjectile::OnSphereOverlap(UPrimitiveComponent* OverlappedComponen
 	}
 }
 
+void ATopDownProjectile::EndProjectile()
+{
+	if (PooledState.bPooled)
+	{
+		if (UTopDownProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UTopDownProjectilePoolSubsystem>())
+		{
+			ProjectilePool->ReleaseProjectile(this);
+			return;
+		}
+	}
+	Destroy();
+}
+
+void ATopDownProjectile::PlayImpactEffects()
+{
+#if TOPDOWN_WITH_COSMETICS
+	ensure(ImpactSound);
+	UGameplayStatics::PlaySoundAtLocation(this, ImpactSound, GetActorLocation(), FRotator().ZeroRotator);
+	ensure(ImpactEffect);
+	UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, ImpactEffect, GetActorLocation());
+	
+	if (LoopingEffectAudioComponent)
+	{
+		LoopingEffectAudioComponent->Stop();
+	}
+#endif
+}
+
+void ATopDownProjectile::ActivatePooledProjectile(const FTransform& LaunchTransform)
+{
+	check(HasAuthority());
+	
+	SetNetDormancy(DORM_Awake);
+	
+	PooledState.bActive = true;
+	++PooledState.LaunchCount;
+	PooledState.LaunchLocation = LaunchTransform.GetLocation();
+	PooledState.LaunchRotation = LaunchTransform.Rotator();
+	LocalLaunchCount = PooledState.LaunchCount;
+
+	StartFlight(PooledState.LaunchLocation, PooledState.LaunchRotation);
+	GetWorldTimerManager().SetTimer(PooledLifeSpanTimerHandle, this, &ATopDownProjectile::EndProjectile, LifeSpan, false);
+	ForceNetUpdate();
+}
+
+void ATopDownProjectile::DeactivatePooledProjectile()
+{
+	check(HasAuthority());
+
+	GetWorldTimerManager().ClearTimer(PooledLifeSpanTimerHandle);
+	StopFlight();
+	DamageEffectSpecHandle = FGameplayEffectSpecHandle();
+	
+	PooledState.bActive = false;
+	// A parked projectile has nothing to replicate. Send this last change and then go dormant until the next launch.
+	SetNetDormancy(DORM_DormantAll);
+	FlushNetDormancy();
+}
+
+void ATopDownProjectile::StartFlight(const FVector& Location, const FRotator& Rotation)
+{
+	bInFlight = true;
+	bCollisionHit = false;
+	
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// Configures the collision sphere to ignore the instigator. The previous shot may have had a different one.
+	Sphere->ClearMoveIgnoreActors();
+	Sphere->IgnoreActorWhenMoving(GetInstigator(), true);
+
+	ProjectileMovementComponent->SetUpdatedComponent(GetRootComponent());
+	ProjectileMovementComponent->Velocity = Rotation.Vector() * ProjectileMovementComponent->InitialSpeed;
+	ProjectileMovementComponent->Activate(true);
+
+#if TOPDOWN_WITH_COSMETICS
+	if (IsValid(LoopingEffectAudioComponent))
+	{
+		LoopingEffectAudioComponent->Play();
+	}
+	else
+	{
+		ensure(LoopingEffectSound);
+		// Not auto destroyed, the same audio component is replayed on every launch.
+		LoopingEffectAudioComponent = UGameplayStatics::SpawnSoundAttached(LoopingEffectSound, Sphere, FName(), GetActorLocation(), FRotator().ZeroRotator,
+			EAttachLocation::KeepWorldPosition, false, 1.f, 1.f, 0.f, nullptr, nullptr, false);
+	}
+#endif
+}
+
+void ATopDownProjectile::StopFlight()
+{
+	bInFlight = false;
+	
+	ProjectileMovementComponent->StopMovementImmediately();
+	ProjectileMovementComponent->Deactivate();
+	
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+	
+	if (LoopingEffectAudioComponent)
+	{
+		LoopingEffectAudioComponent->Stop();
+	}
+}
+
+void ATopDownProjectile::OnRep_PooledState()
+{
+	// BeginPlay picks up the initial state.
+	if (!HasActorBegunPlay()) return;
+
+	if (PooledState.bActive && PooledState.LaunchCount != LocalLaunchCount)
+	{
+		LocalLaunchCount = PooledState.LaunchCount;
+		StartFlight(PooledState.LaunchLocation, PooledState.LaunchRotation);
+	}
+	else if (!PooledState.bActive && bInFlight)
+	{
+		// Same as Destroyed for a non pooled projectile, play the impact if we did not see the overlap locally.
+		if (!bCollisionHit)
+		{
+			PlayImpactEffects();
+		}
+		StopFlight();
+	}
+}
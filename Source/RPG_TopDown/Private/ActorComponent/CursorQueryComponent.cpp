@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ActorComponent/CursorQueryComponent.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+#include "Subsystem/TopDownSpatialGridSubsystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cursor Traces Performed"), STAT_CursorTracesPerformed, STATGROUP_TopDown);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cursor Traces Avoided"), STAT_CursorTracesAvoided, STATGROUP_TopDown);
+
+UCursorQueryComponent::UCursorQueryComponent()
+{
+	// Driven by the owning controller's queries, nothing to do on tick.
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+bool UCursorQueryComponent::GetHighlightActor(AActor*& OutActor, bool bUseSpatialGrid, TSubclassOf<AActor> ActorClassFilter)
+{
+	UpdateCursorState();
+
+	if (bUseSpatialGrid)
+	{
+		if (const UTopDownSpatialGridSubsystem* SpatialGrid = GetWorld()->GetSubsystem<UTopDownSpatialGridSubsystem>())
+		{
+			if (bPickedActorUpToDate)
+			{
+				++TracesAvoided;
+				INC_DWORD_STAT(STAT_CursorTracesAvoided);
+				OutActor = PickedActor.Get();
+				return true;
+			}
+
+			const APlayerController* PlayerController = GetPlayerController();
+			FVector RayStart;
+			FVector RayDirection;
+			if (!PlayerController || !PlayerController->DeprojectMousePositionToWorld(RayStart, RayDirection)) return false;
+
+			++TracesPerformed;
+			INC_DWORD_STAT(STAT_CursorTracesPerformed);
+			AActor* Picked = SpatialGrid->RayPick(RayStart, RayStart + RayDirection * PlayerController->HitResultTraceDistance, ActorClassFilter);
+			if (Picked)
+			{
+				// The grid knows nothing about world geometry. Drop the pick if the shared visibility trace stopped in front of it.
+				const FHitResult& CursorHitResult = GetVisibilityHit();
+				const float PickDistance = FVector::DotProduct(Picked->GetActorLocation() - RayStart, RayDirection) - Picked->GetSimpleCollisionRadius();
+				if (CursorHitResult.bBlockingHit && CursorHitResult.GetActor() != Picked && CursorHitResult.Distance < PickDistance)
+				{
+					Picked = nullptr;
+				}
+			}
+			PickedActor = Picked;
+			bPickedActorUpToDate = true;
+			OutActor = PickedActor.Get();
+			return true;
+		}
+	}
+
+	// Without the grid the highlight shares the visibility trace with ability targeting.
+	const FHitResult& CursorHitResult = GetVisibilityHit();
+	OutActor = CursorHitResult.GetActor();
+	return CursorHitResult.bBlockingHit;
+}
+
+const FHitResult& UCursorQueryComponent::GetVisibilityHit()
+{
+	return GetCachedHit(VisibilityQuery, ECC_Visibility);
+}
+
+const FHitResult& UCursorQueryComponent::GetFreshVisibilityHit()
+{
+	UpdateCursorState();
+	return TraceIntoCache(VisibilityQuery, ECC_Visibility);
+}
+
+const FHitResult& UCursorQueryComponent::GetNavigationHit()
+{
+	return GetCachedHit(NavigationQuery, ECC_Navigation);
+}
+
+const FHitResult& UCursorQueryComponent::GetCachedHit(FCursorQueryCache& Cache, ECollisionChannel TraceChannel)
+{
+	UpdateCursorState();
+
+	if (Cache.bUpToDate)
+	{
+		++TracesAvoided;
+		INC_DWORD_STAT(STAT_CursorTracesAvoided);
+		return Cache.HitResult;
+	}
+
+	return TraceIntoCache(Cache, TraceChannel);
+}
+
+const FHitResult& UCursorQueryComponent::TraceIntoCache(FCursorQueryCache& Cache, ECollisionChannel TraceChannel)
+{
+	Cache.HitResult = FHitResult();
+	if (const APlayerController* PlayerController = GetPlayerController())
+	{
+		++TracesPerformed;
+		INC_DWORD_STAT(STAT_CursorTracesPerformed);
+		PlayerController->GetHitResultUnderCursor(TraceChannel, false, Cache.HitResult);
+	}
+	Cache.bUpToDate = true;
+	return Cache.HitResult;
+}
+
+void UCursorQueryComponent::UpdateCursorState()
+{
+	// Everything asked for within one frame is answered from the same cursor state.
+	if (LastUpdateFrame == GFrameCounter) return;
+	LastUpdateFrame = GFrameCounter;
+
+	const APlayerController* PlayerController = GetPlayerController();
+	if (PlayerController == nullptr)
+	{
+		InvalidateQueries();
+		return;
+	}
+
+	FVector2D NewMousePosition = FVector2D::ZeroVector;
+	float MouseX = 0.f;
+	float MouseY = 0.f;
+	const bool bNewHasMousePosition = PlayerController->GetMousePosition(MouseX, MouseY);
+	if (bNewHasMousePosition)
+	{
+		NewMousePosition = FVector2D(MouseX, MouseY);
+	}
+
+	FVector NewCameraLocation = FVector::ZeroVector;
+	FRotator NewCameraRotation = FRotator::ZeroRotator;
+	if (const APlayerCameraManager* CameraManager = PlayerController->PlayerCameraManager)
+	{
+		NewCameraLocation = CameraManager->GetCameraLocation();
+		NewCameraRotation = CameraManager->GetCameraRotation();
+	}
+
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	const bool bCursorMoved = bNewHasMousePosition != bHasMousePosition || NewMousePosition != MousePosition;
+	const bool bCameraMoved = !NewCameraLocation.Equals(CameraLocation, CameraLocationTolerance) || !NewCameraRotation.Equals(CameraRotation, CameraRotationTolerance);
+	if (bCursorMoved || bCameraMoved || CurrentTime - LastQueryTime > MaxCacheAge)
+	{
+		MousePosition = NewMousePosition;
+		bHasMousePosition = bNewHasMousePosition;
+		CameraLocation = NewCameraLocation;
+		CameraRotation = NewCameraRotation;
+		LastQueryTime = CurrentTime;
+		InvalidateQueries();
+	}
+}
+
+void UCursorQueryComponent::InvalidateQueries()
+{
+	VisibilityQuery.bUpToDate = false;
+	NavigationQuery.bUpToDate = false;
+	bPickedActorUpToDate = false;
+}
+
+APlayerController* UCursorQueryComponent::GetPlayerController() const
+{
+	return Cast<APlayerController>(GetOwner());
+}
@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ActorComponent/SignificanceComponent.h"
+
+#include "SignificanceManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/WidgetComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+#include "Subsystem/TopDownHealthBarSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_SignificanceUpdate, STATGROUP_TopDown);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Tier High"), STAT_SignificanceTierHigh, STATGROUP_TopDown);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Tier Medium"), STAT_SignificanceTierMedium, STATGROUP_TopDown);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Tier Low"), STAT_SignificanceTierLow, STATGROUP_TopDown);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Tier Lowest"), STAT_SignificanceTierLowest, STATGROUP_TopDown);
+
+static TAutoConsoleVariable<bool> CVarSignificanceEnabled(
+	TEXT("TopDown.Significance.Enabled"),
+	true,
+	TEXT("Budget enemy animation, movement and widget ticks by significance. Turning it off puts everything back into the High tier."));
+
+namespace TopDownSignificance
+{
+	static const FName EnemyTag(TEXT("TopDownSignificance"));
+
+	static void AdjustTierStat(ESignificanceTier Tier, int32 Delta)
+	{
+		switch (Tier)
+		{
+		case ESignificanceTier::High:	INC_DWORD_STAT_BY(STAT_SignificanceTierHigh, Delta); break;
+		case ESignificanceTier::Medium:	INC_DWORD_STAT_BY(STAT_SignificanceTierMedium, Delta); break;
+		case ESignificanceTier::Low:	INC_DWORD_STAT_BY(STAT_SignificanceTierLow, Delta); break;
+		case ESignificanceTier::Lowest:	INC_DWORD_STAT_BY(STAT_SignificanceTierLowest, Delta); break;
+		}
+	}
+}
+
+USignificanceComponent::USignificanceComponent()
+{
+	// The significance manager calls us, nothing to do on tick.
+	PrimaryComponentTick.bCanEverTick = false;
+
+	TierSettings.SetNum(4);
+	TierSettings[static_cast<int32>(ESignificanceTier::Medium)].MinDistance = 1500.f;
+	TierSettings[static_cast<int32>(ESignificanceTier::Medium)].AnimationTickInterval = 1.f / 30.f;
+	TierSettings[static_cast<int32>(ESignificanceTier::Medium)].MovementTickInterval = 1.f / 30.f;
+	TierSettings[static_cast<int32>(ESignificanceTier::Medium)].WidgetRedrawTime = 0.1f;
+
+	TierSettings[static_cast<int32>(ESignificanceTier::Low)].MinDistance = 3000.f;
+	TierSettings[static_cast<int32>(ESignificanceTier::Low)].AnimationTickInterval = 0.1f;
+	TierSettings[static_cast<int32>(ESignificanceTier::Low)].MovementTickInterval = 0.1f;
+	TierSettings[static_cast<int32>(ESignificanceTier::Low)].bShowWidgets = false;
+
+	TierSettings[static_cast<int32>(ESignificanceTier::Lowest)].MinDistance = 6000.f;
+	TierSettings[static_cast<int32>(ESignificanceTier::Lowest)].AnimationTickInterval = 0.25f;
+	TierSettings[static_cast<int32>(ESignificanceTier::Lowest)].MovementTickInterval = 0.25f;
+	TierSettings[static_cast<int32>(ESignificanceTier::Lowest)].bShowWidgets = false;
+}
+
+void USignificanceComponent::NotifyCombatActivity()
+{
+	LastCombatActivityTime = GetWorld()->GetTimeSeconds();
+}
+
+void USignificanceComponent::UpdateSignificance(const UWorld* World, const FTransform& ViewTransform)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SignificanceUpdate);
+
+	if (USignificanceManager* SignificanceManager = USignificanceManager::Get(World))
+	{
+		SignificanceManager->Update(TArrayView<const FTransform>(&ViewTransform, 1));
+	}
+}
+
+void USignificanceComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Nobody looks at anything on a dedicated server.
+	if (GetNetMode() == NM_DedicatedServer) return;
+
+	USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld());
+	if (SignificanceManager == nullptr) return;
+
+	SignificanceManager->RegisterObject(this, TopDownSignificance::EnemyTag,
+		[this](USignificanceManager::FManagedObjectInfo*, const FTransform& ViewTransform)
+		{
+			return CalculateSignificance(ViewTransform);
+		},
+		USignificanceManager::EPostSignificanceType::Sequential,
+		[this](USignificanceManager::FManagedObjectInfo*, float, float, bool)
+		{
+			PostSignificanceUpdate();
+		});
+	bRegistered = true;
+	TopDownSignificance::AdjustTierStat(SignificanceTier, 1);
+}
+
+void USignificanceComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bRegistered)
+	{
+		if (USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld()))
+		{
+			SignificanceManager->UnregisterObject(this);
+		}
+		TopDownSignificance::AdjustTierStat(SignificanceTier, -1);
+		bRegistered = false;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+float USignificanceComponent::CalculateSignificance(const FTransform& ViewTransform)
+{
+	const FVector ToOwner = GetOwner()->GetActorLocation() - ViewTransform.GetLocation();
+	const FVector ViewDirection = ViewTransform.GetRotation().GetForwardVector();
+	const float DistanceAlongView = FVector::DotProduct(ToOwner, ViewDirection);
+
+	if (DistanceAlongView <= 0.f)
+	{
+		// Behind the camera.
+		EffectiveDistance = UE_BIG_NUMBER;
+	}
+	else
+	{
+		EffectiveDistance = (ToOwner - DistanceAlongView * ViewDirection).Size();
+		if (IsCombatRelevant())
+		{
+			EffectiveDistance *= CombatDistanceScale;
+		}
+	}
+
+	// The manager sorts by significance, higher is more significant.
+	return 1.f / (1.f + EffectiveDistance);
+}
+
+void USignificanceComponent::PostSignificanceUpdate()
+{
+	if (!CVarSignificanceEnabled.GetValueOnGameThread())
+	{
+		SetSignificanceTier(ESignificanceTier::High);
+		return;
+	}
+
+	// Step out only once past the next boundary plus the hysteresis band, step back in only once inside it by the same band.
+	int32 NewTier = static_cast<int32>(SignificanceTier);
+	const int32 LowestTier = static_cast<int32>(ESignificanceTier::Lowest);
+	while (NewTier < LowestTier && EffectiveDistance > TierSettings[NewTier + 1].MinDistance + HysteresisDistance)
+	{
+		++NewTier;
+	}
+	while (NewTier > 0 && EffectiveDistance < TierSettings[NewTier].MinDistance - HysteresisDistance)
+	{
+		--NewTier;
+	}
+	SetSignificanceTier(static_cast<ESignificanceTier>(NewTier));
+}
+
+void USignificanceComponent::SetSignificanceTier(ESignificanceTier NewTier)
+{
+	if (NewTier == SignificanceTier) return;
+
+	if (bRegistered)
+	{
+		TopDownSignificance::AdjustTierStat(SignificanceTier, -1);
+		TopDownSignificance::AdjustTierStat(NewTier, 1);
+	}
+	SignificanceTier = NewTier;
+	ApplySignificanceTier();
+}
+
+void USignificanceComponent::ApplySignificanceTier() const
+{
+	const FSignificanceTierSettings& Settings = TierSettings[static_cast<int32>(SignificanceTier)];
+	AActor* Owner = GetOwner();
+
+	Owner->ForEachComponent<USkeletalMeshComponent>(false, [&Settings](USkeletalMeshComponent* SkeletalMeshComponent)
+	{
+		SkeletalMeshComponent->SetComponentTickInterval(Settings.AnimationTickInterval);
+	});
+
+	// On a listen server these characters are authoritative for remote players as well, so movement keeps its full rate there.
+	const ACharacter* Character = Cast<ACharacter>(Owner);
+	if (Character && Character->GetCharacterMovement() && GetNetMode() != NM_ListenServer)
+	{
+		Character->GetCharacterMovement()->SetComponentTickInterval(Settings.MovementTickInterval);
+	}
+
+	Owner->ForEachComponent<UWidgetComponent>(false, [&Settings](UWidgetComponent* WidgetComponent)
+	{
+		WidgetComponent->SetVisibility(Settings.bShowWidgets);
+		WidgetComponent->SetComponentTickEnabled(Settings.bShowWidgets);
+		WidgetComponent->SetRedrawTime(Settings.WidgetRedrawTime);
+	});
+	if (UTopDownHealthBarSubsystem* HealthBarSubsystem = GetWorld()->GetSubsystem<UTopDownHealthBarSubsystem>())
+	{
+		HealthBarSubsystem->SetHidden(Owner, !Settings.bShowWidgets);
+	}
+}
+
+bool USignificanceComponent::IsCombatRelevant() const
+{
+	return GetWorld()->GetTimeSeconds() - LastCombatActivityTime < CombatRelevanceTime;
+}
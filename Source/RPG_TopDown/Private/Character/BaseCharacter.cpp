@@ -7,6 +7,7 @@
 #include "AbilitySystem/BaseAbilitySystemComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "RPG_TopDown/RPG_TopDown.h"
+#include "Subsystem/TopDownSpatialGridSubsystem.h"
 
 // Sets default values
 ABaseCharacter::ABaseCharacter()
@@ -33,7 +34,32 @@ ABaseCharacter::ABaseCharacter()
 void ABaseCharacter::BeginPlay()
 {
 	Super::BeginPlay();
+
+	RegisterWithSpatialGrid();
+}
+
+void ABaseCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromSpatialGrid();
 	
+	Super::EndPlay(EndPlayReason);
+}
+
+void ABaseCharacter::RegisterWithSpatialGrid()
+{
+	if (UTopDownSpatialGridSubsystem* SpatialGrid = GetWorld()->GetSubsystem<UTopDownSpatialGridSubsystem>())
+	{
+		const UCapsuleComponent* Capsule = GetCapsuleComponent();
+		SpatialGrid->RegisterActor(this, Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight());
+	}
+}
+
+void ABaseCharacter::UnregisterFromSpatialGrid()
+{
+	if (UTopDownSpatialGridSubsystem* SpatialGrid = GetWorld()->GetSubsystem<UTopDownSpatialGridSubsystem>())
+	{
+		SpatialGrid->UnregisterActor(this);
+	}
 }
 
 UAbilitySystemComponent* ABaseCharacter::GetAbilitySystemComponent() const
@@ -80,6 +106,9 @@ void ABaseCharacter::MulticastHandleDeath_Implementation()
 	GetCapsuleComponent()->SetCollisionResponseToAllChannels(ECR_Ignore);
 	GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Block);
 
+	// Dead characters can no longer be picked or hit by area queries, same as they stop blocking traces.
+	UnregisterFromSpatialGrid();
+
 	DissolveEffect();
 }
 
@@ -121,6 +150,7 @@ void ABaseCharacter::AddCharacterAbilities() const
 
 void ABaseCharacter::DissolveEffect()
 {
+#if TOPDOWN_WITH_COSMETICS
 	if (IsValid(DissolveMaterialInstance))
 	{
 		UMaterialInstanceDynamic* DynamicMaterialInstance = UMaterialInstanceDynamic::Create(DissolveMaterialInstance, this);
@@ -133,6 +163,7 @@ void ABaseCharacter::DissolveEffect()
 		WeaponMesh->SetMaterial(0, DynamicMaterialInstance);
 		StartWeaponMeshDissolveTimeline(DynamicMaterialInstance);
 	}
+#endif
 }
 
 
@@ -7,8 +7,11 @@
 #include "AbilitySystem/BaseAbilitySystemComponent.h"
 #include "AbilitySystem/BaseAttributeSet.h"
 #include "AbilitySystem/TopDownAbilitySystemLibrary.h"
+#include "ActorComponent/SignificanceComponent.h"
 #include "Components/WidgetComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Subsystem/TopDownCrowdSubsystem.h"
+#include "Subsystem/TopDownHealthBarSubsystem.h"
 #include "RPG_TopDown/RPG_TopDown.h"
 #include "UI/Widget/BaseUserWidget.h"
 
@@ -27,6 +30,19 @@ AEnemyCharacter::AEnemyCharacter()
 	// Create and initialize the HealthBar
 	HealthBar = CreateDefaultSubobject<UWidgetComponent>("HealthBar");
 	HealthBar->SetupAttachment(GetRootComponent());
+#if !TOPDOWN_WITH_COSMETICS
+	// Nothing draws the widget on a dedicated server, so don't pay for its tick either.
+	HealthBar->PrimaryComponentTick.bCanEverTick = false;
+#endif
+
+	// Throttles animation, movement and health bar ticks for enemies far from the middle of the screen
+	Significance = CreateDefaultSubobject<USignificanceComponent>("Significance");
+}
+
+void AEnemyCharacter::InitializeSpawnDefaults(int32 InLevel, ECharacterClass InCharacterClass)
+{
+	Level = InLevel;
+	CharacterCLass = InCharacterClass;
 }
 
 void AEnemyCharacter::BeginPlay()
@@ -41,6 +57,23 @@ void AEnemyCharacter::BeginPlay()
 
 	// Giving Startup Abilities to Enemy such as Hit React ability to play Hit React Montage.
 	UTopDownAbilitySystemLibrary::GiveStartupAbilities(this, AbilitySystemComponent);
+
+	RegisterWithCrowd();
+}
+
+void AEnemyCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromCrowd();
+	if (UTopDownHealthBarSubsystem* HealthBarSubsystem = GetWorld()->GetSubsystem<UTopDownHealthBarSubsystem>())
+	{
+		HealthBarSubsystem->UnregisterActor(this);
+	}
+	if (UTopDownAttributeStoreSubsystem* AttributeStore = UTopDownAttributeStoreSubsystem::Get(this))
+	{
+		AttributeStore->Unregister(AttributeStoreHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AEnemyCharacter::InitAbilityActorInfo()
@@ -78,6 +111,12 @@ void AEnemyCharacter::InitAbilityActorInfo()
 
 	// Initializing Primary, Secondary and Vital Attributes.
 	InitializeDefaultAttributes();
+
+	// Mirror the combat attributes for systems that walk every enemy, after the defaults so the store starts out seeded.
+	if (UTopDownAttributeStoreSubsystem* AttributeStore = UTopDownAttributeStoreSubsystem::Get(this))
+	{
+		AttributeStoreHandle = AttributeStore->Register(AbilitySystemComponent);
+	}
 	
 	InitializeHealthBarWidgetController();
 	
@@ -98,6 +137,13 @@ void AEnemyCharacter::BindAndBroadcastAttributeChanges()
 			[this](const FOnAttributeChangeData& Data)
 			{
 				OnHealthChanged.Broadcast(Data.NewValue);
+				if (bUseSharedHealthBar)
+				{
+					if (UTopDownHealthBarSubsystem* HealthBarSubsystem = GetWorld()->GetSubsystem<UTopDownHealthBarSubsystem>())
+					{
+						HealthBarSubsystem->SetHealth(this, Data.NewValue);
+					}
+				}
 			}
 		);
 		
@@ -106,6 +152,13 @@ void AEnemyCharacter::BindAndBroadcastAttributeChanges()
 			[this](const FOnAttributeChangeData& Data)
 			{
 				OnMaxHealthChanged.Broadcast(Data.NewValue);
+				if (bUseSharedHealthBar)
+				{
+					if (UTopDownHealthBarSubsystem* HealthBarSubsystem = GetWorld()->GetSubsystem<UTopDownHealthBarSubsystem>())
+					{
+						HealthBarSubsystem->SetMaxHealth(this, Data.NewValue);
+					}
+				}
 			}
 		);
 		
@@ -115,6 +168,14 @@ void AEnemyCharacter::BindAndBroadcastAttributeChanges()
 		// Broadcasting initial values
 		OnHealthChanged.Broadcast(BaseAttributeSet->GetHealth());
 		OnMaxHealthChanged.Broadcast(BaseAttributeSet->GetMaxHealth());
+		if (bUseSharedHealthBar)
+		{
+			if (UTopDownHealthBarSubsystem* HealthBarSubsystem = GetWorld()->GetSubsystem<UTopDownHealthBarSubsystem>())
+			{
+				HealthBarSubsystem->SetHealth(this, BaseAttributeSet->GetHealth());
+				HealthBarSubsystem->SetMaxHealth(this, BaseAttributeSet->GetMaxHealth());
+			}
+		}
 	}
 }
 
@@ -132,11 +193,28 @@ void AEnemyCharacter::InitializeDefaultAttributes() const
 // The function is designed to initialize the health bar widget controller by setting it to the enemy class itself.
 void AEnemyCharacter::InitializeHealthBarWidgetController()
 {
+#if TOPDOWN_WITH_COSMETICS
+	if (bUseSharedHealthBar)
+	{
+		// The HUD draws the bar, so the widget component and its render target aren't needed.
+		if (HealthBar)
+		{
+			HealthBar->DestroyComponent();
+			HealthBar = nullptr;
+		}
+		if (UTopDownHealthBarSubsystem* HealthBarSubsystem = GetWorld()->GetSubsystem<UTopDownHealthBarSubsystem>())
+		{
+			HealthBarSubsystem->RegisterActor(this, 0.f, 0.f, SharedHealthBarHeight);
+		}
+		return;
+	}
+	
 	// Setting Widget Controller to Enemy Class itself.
 	if (UBaseUserWidget* BaseUserWidget = Cast<UBaseUserWidget>(HealthBar->GetUserWidgetObject()))
 	{
 		BaseUserWidget->SetWidgetController(this);
 	}
+#endif
 }
 
 // Callback function to RegisterGameplayTagEvent when the enemy gets hit by a player
@@ -144,6 +222,10 @@ void AEnemyCharacter::HitReactTagChange(const FGameplayTag CallbackTag, const in
 {
 	bHitReacting = NewCount > 0;
 	GetCharacterMovement()->MaxWalkSpeed = bHitReacting ? 0.f : BaseWalkSpeed;
+	if (bHitReacting)
+	{
+		Significance->NotifyCombatActivity();
+	}
 }
 
 //Highlight the actor by enabling custom depth rendering with a specific stencil value
@@ -157,6 +239,8 @@ void AEnemyCharacter::HighlightActor()
 	WeaponMesh->SetRenderCustomDepth(true);
 	// Set the stencil value for the weapon mesh to red
 	WeaponMesh->SetCustomDepthStencilValue(CUSTOM_DEPTH_RED);
+	// The player is aiming at us, keep full rate ticks for a while
+	Significance->NotifyCombatActivity();
 }
 
 
@@ -183,8 +267,27 @@ ECharacterClass AEnemyCharacter::GetCharacterClass()
 void AEnemyCharacter::Die()
 {
 	SetLifeSpan(LifeSpan);
+	// Dead enemies stay actors until their life span runs out.
+	UnregisterFromCrowd();
 	Super::Die();
 	
 }
 
+void AEnemyCharacter::RegisterWithCrowd()
+{
+	// The server decides which enemies exist as actors.
+	if (!bCanDemoteToCrowd || !HasAuthority()) return;
+
+	if (UTopDownCrowdSubsystem* Crowd = GetWorld()->GetSubsystem<UTopDownCrowdSubsystem>())
+	{
+		Crowd->RegisterEnemy(this);
+	}
+}
 
+void AEnemyCharacter::UnregisterFromCrowd()
+{
+	if (UTopDownCrowdSubsystem* Crowd = GetWorld()->GetSubsystem<UTopDownCrowdSubsystem>())
+	{
+		Crowd->UnregisterEnemy(this);
+	}
+}
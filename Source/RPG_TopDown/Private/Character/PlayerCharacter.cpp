@@ -120,6 +120,7 @@ void APlayerCharacter::InitAbilityActorInfo()
 		// Cast the controller to APlayerCharacterController
 		PlayerPC = Cast<APlayerCharacterController>(GetController());
         
+#if TOPDOWN_WITH_COSMETICS
 		if (PlayerPC)
 		{
 			// Cast the HUD to ATopDownHUD
@@ -129,6 +130,7 @@ void APlayerCharacter::InitAbilityActorInfo()
 				TopDownHUD->InitializeOverlayWidget(PlayerPC, PlayerPS, AbilitySystemComponent, AttributeSet);
 			}
 		}
+#endif
 
 		// This function initializes the character's default attributes by applying primary and secondary attribute effects to the character.
 		InitializeDefaultAttributes();
@@ -7,11 +7,15 @@
 #include "EnhancedInputSubsystems.h"
 #include "InputAction.h"
 #include "InputActionValue.h"
-#include "NavigationPath.h"
+#include "NavigationData.h"
 #include "NavigationSystem.h"
+#include "NavFilters/NavigationQueryFilter.h"
 #include "TopDownGameplayTags.h"
 #include "AbilitySystem/BaseAbilitySystemComponent.h"
 #include "ActorComponent/CameraMovementComponent.h"
+#include "ActorComponent/CursorQueryComponent.h"
+#include "ActorComponent/SignificanceComponent.h"
+#include "Character/EnemyCharacter.h"
 #include "Components/SplineComponent.h"
 #include "GameFramework/Character.h"
 #include "Input/TopDownInputComponent.h"
@@ -27,6 +31,7 @@ APlayerCharacterController::APlayerCharacterController()
 	bReplicates = true;
 
 	Spline = CreateDefaultSubobject<USplineComponent>("Spline");
+	CursorQuery = CreateDefaultSubobject<UCursorQueryComponent>("CursorQuery");
 }
 
 void APlayerCharacterController::PlayerTick(float DeltaTime)
@@ -35,6 +40,12 @@ void APlayerCharacterController::PlayerTick(float DeltaTime)
 
 	CursorTrace();
 	AutoRun();
+
+	// Tier enemies against this player's view before they tick.
+	if (PlayerCameraManager)
+	{
+		USignificanceComponent::UpdateSignificance(GetWorld(), FTransform(PlayerCameraManager->GetCameraRotation(), PlayerCameraManager->GetCameraLocation()));
+	}
 }
 
 void APlayerCharacterController::BeginPlay()
@@ -89,35 +100,94 @@ void APlayerCharacterController::AutoRun()
 	
 	if (APawn* ControlledPawn = GetPawn())
 	{
-		const FVector LocationOnSpline = Spline->FindLocationClosestToWorldLocation(ControlledPawn->GetActorLocation(), ESplineCoordinateSpace::World);
-		const FVector Direction = Spline->FindDirectionClosestToWorldLocation(LocationOnSpline, ESplineCoordinateSpace::World);
-		ControlledPawn->AddMovementInput(Direction);
-
-		const float DistanceToDestination = (LocationOnSpline - CachedMoveDestination).Length();
-		if (DistanceToDestination <= AutoRunAcceptanceRadius)
+		FVector Direction;
+		if (PathFollower.Update(ControlledPawn->GetActorLocation(), Direction))
+		{
+			ControlledPawn->AddMovementInput(Direction);
+		}
+		else
 		{
 			bAutoRunning = false;
 		}
 	}
 }
 
-// Performs a line trace (raycast) from the cursor's position to detect what the cursor is pointing at.
+void APlayerCharacterController::RequestMovePath()
+{
+	AbortMovePathQuery();
+	
+	const APawn* ControlledPawn = GetPawn();
+	UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (ControlledPawn == nullptr || NavigationSystem == nullptr) return;
+
+	const FNavAgentProperties& AgentProperties = ControlledPawn->GetNavAgentPropertiesRef();
+	const FVector PathStart = ControlledPawn->GetActorLocation();
+	const ANavigationData* NavigationData = NavigationSystem->GetNavDataForProps(AgentProperties, PathStart);
+	if (NavigationData == nullptr) return;
+
+	// The path is found off the game thread, OnMovePathFound gets it on a later frame.
+	FPathFindingQuery PathQuery(this, *NavigationData, PathStart, CachedMoveDestination, UNavigationQueryFilter::GetQueryFilter(*NavigationData, this, nullptr));
+	PendingMovePathQueryId = NavigationSystem->FindPathAsync(AgentProperties, PathQuery,
+		FNavPathQueryDelegate::CreateUObject(this, &APlayerCharacterController::OnMovePathFound));
+}
+
+void APlayerCharacterController::AbortMovePathQuery()
+{
+	if (PendingMovePathQueryId == INVALID_NAVQUERYID) return;
+	
+	if (UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		NavigationSystem->AbortAsyncFindPathRequest(PendingMovePathQueryId);
+	}
+	PendingMovePathQueryId = INVALID_NAVQUERYID;
+}
+
+void APlayerCharacterController::OnMovePathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr NavigationPath)
+{
+	// An older query that finished before it could be aborted.
+	if (QueryId != PendingMovePathQueryId) return;
+	PendingMovePathQueryId = INVALID_NAVQUERYID;
+	
+	if (Result != ENavigationQueryResult::Success || !NavigationPath.IsValid()) return;
+
+	const TArray<FNavPathPoint>& NavigationPathPoints = NavigationPath->GetPathPoints();
+	if (NavigationPathPoints.IsEmpty()) return;
+	
+	TArray<FVector> PathPoints;
+	PathPoints.Reserve(NavigationPathPoints.Num());
+	for (const FNavPathPoint& PathPoint : NavigationPathPoints)
+	{
+		PathPoints.Add(PathPoint.Location);
+	}
+	// Rebuilds the spline once for the whole path.
+	Spline->SetSplinePoints(PathPoints, ESplineCoordinateSpace::World);
+
+#if ENABLE_DRAW_DEBUG
+	for (const FVector& PointLocation : PathPoints)
+	{
+		DrawDebugSphere(GetWorld(), PointLocation, 12.f, 12, FColor::Green, false, 5.f);
+	}
+#endif
+
+	PathFollower.AcceptanceRadius = AutoRunAcceptanceRadius;
+	PathFollower.LookAheadDistance = AutoRunLookAheadDistance;
+	PathFollower.CornerTrimRadius = AutoRunCornerTrimRadius;
+	PathFollower.SetPath(PathPoints);
+	bAutoRunning = true;
+}
+
+// Asks the cursor query component what the cursor is pointing at, it only traces again when the cursor or camera moved.
 // It updates the highlighted actor if the cursor moves over a different actor.
 void APlayerCharacterController::CursorTrace()
 {
-	// Declare a hit result to store the outcome of the trace
-	FHitResult CursorHitResult;
-	// Perform a line trace (ray cast) under the cursor using the visibility channel
-	GetHitResultUnderCursor(ECC_Visibility, false, CursorHitResult);
+	AActor* ActorUnderCursor = nullptr;
 	// If the trace did not hit anything, exit the function
-	if (!CursorHitResult.bBlockingHit) return;
+	if (!TraceActorUnderCursor(ActorUnderCursor)) return;
 	
 	// Store the actor hit by the previous trace
 	LastActor = ThisActor;
 	// Store the actor hit by the current trace
-	ThisActor = CursorHitResult.GetActor();
-	//GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::Blue,
-	//FString::Printf(TEXT("EnemyCharacter %s: HighlightActor Called"), *CursorHitResult.GetActor()->GetName()));
+	ThisActor = ActorUnderCursor;
     
 	// If the actor under the cursor has changed since the last frame
 	if (ThisActor != LastActor)
@@ -129,6 +199,11 @@ void APlayerCharacterController::CursorTrace()
 	}
 }
 
+bool APlayerCharacterController::TraceActorUnderCursor(AActor*& OutActor) const
+{
+	return CursorQuery->GetHighlightActor(OutActor, bUseSpatialGridCursorPick, AEnemyCharacter::StaticClass());
+}
+
 // Configures the cursor to be visible and allows both game and UI interactions.
 // The cursor is not locked to the viewport and remains visible during capture operations.
 void APlayerCharacterController::SetCursorSettings()
@@ -171,6 +246,7 @@ void APlayerCharacterController::Move(const FInputActionValue& InputActionValue)
 	if (ControlledPawn)
 	{
 		bAutoRunning = false;
+		AbortMovePathQuery();
 		// Adds movement in the forward direction based on the Y input value (forward/backward)
 		ControlledPawn->AddMovementInput(ForwardDirection, InputAxisVector.Y);
 		// Adds movement in the right direction based on the X input value (left/right)
@@ -201,7 +277,12 @@ void APlayerCharacterController::AbilityInputTagPressed(const FGameplayTag Input
 	if (InputTag.MatchesTagExact(FTopDownGameplayTags::Get().InputTag_LMB))
 	{
 		bTargeting = ThisActor ? true : false;
-		bAutoRunning = false;
+		// A click keeps us on the current path until the new one arrives, only targeting stops us right away.
+		if (bTargeting)
+		{
+			bAutoRunning = false;
+			AbortMovePathQuery();
+		}
 	}
 }
 
@@ -224,24 +305,9 @@ void APlayerCharacterController::AbilityInputTagReleased(const FGameplayTag Inpu
 	
 	if (!bTargeting && !bShiftKeyDown)
 	{
-		const APawn* ControlledPawn = GetPawn();
-		if (FollowTime <= ShortPressThreshold && ControlledPawn)
+		if (FollowTime <= ShortPressThreshold && GetPawn())
 		{
-			if (UNavigationPath* NavigationPath = UNavigationSystemV1::FindPathToLocationSynchronously(this,
-				ControlledPawn->GetActorLocation(), CachedMoveDestination))
-			{
-				Spline->ClearSplinePoints();
-				for (const FVector& PointLocation : NavigationPath->PathPoints)
-				{
-					Spline->AddSplinePoint(PointLocation, ESplineCoordinateSpace::World);
-					DrawDebugSphere(GetWorld(), PointLocation, 12.f, 12, FColor::Green, false, 5.f);
-				}
-				if (NavigationPath->PathPoints.Num() > 0)
-				{
-					CachedMoveDestination = NavigationPath->PathPoints.Last();
-					bAutoRunning = true;
-				}
-			}
+			RequestMovePath();
 		}
 		FollowTime = 0.f;
 		bTargeting = false;
@@ -273,13 +339,18 @@ void APlayerCharacterController::AbilityInputTagHeld(const FGameplayTag InputTag
 	{
 		FollowTime += GetWorld()->GetDeltaSeconds();
 
-		FHitResult HitResult;
 		// ECC_GameTraceChannel1 = Navigation
-		if (GetHitResultUnderCursor(ECC_Navigation, false, HitResult))
+		const FHitResult& HitResult = CursorQuery->GetNavigationHit();
+		if (HitResult.bBlockingHit)
 		{
 			CachedMoveDestination = HitResult.ImpactPoint;
 		}
 
+		// Still within a click, keep running the previous path. Holding past it means we follow the cursor instead.
+		if (bAutoRunning && FollowTime <= ShortPressThreshold) return;
+		bAutoRunning = false;
+		AbortMovePathQuery();
+
 		if (APawn* ControlledPawn = GetPawn())
 		{
 			const FVector WorldDirection = (CachedMoveDestination - ControlledPawn->GetActorLocation()).GetSafeNormal();
@@ -300,16 +371,99 @@ UBaseAbilitySystemComponent* APlayerCharacterController::GetAbilitySystemCompone
 	return BaseAbilitySystemComponent;
 }
 
-void APlayerCharacterController::ShowDamageNumber_Implementation(float DamageAmount, ACharacter* TargetCharacter, bool bEvadedHit, bool bCriticalHit, bool bBlockChance)
+void APlayerCharacterController::ShowDamageNumber(float DamageAmount, ACharacter* TargetCharacter, bool bEvadedHit, bool bCriticalHit, bool bBlockChance)
 {
+	if (!IsValid(TargetCharacter)) return;
+
+	if (bMergeDamageNumbersPerTarget)
+	{
+		if (FDamageNumberEntry* PendingEntry = PendingDamageNumbers.FindByPredicate([TargetCharacter](const FDamageNumberEntry& Entry) { return Entry.TargetCharacter == TargetCharacter; }))
+		{
+			// A merged number only reads as evaded if every hit in it was evaded.
+			PendingEntry->DamageAmount += DamageAmount;
+			PendingEntry->bEvadedHit &= bEvadedHit;
+			PendingEntry->bCriticalHit |= bCriticalHit;
+			PendingEntry->bBlockChance |= bBlockChance;
+			return;
+		}
+	}
+
+	if (PendingDamageNumbers.IsEmpty())
+	{
+		GetWorldTimerManager().SetTimerForNextTick(this, &APlayerCharacterController::FlushDamageNumbers);
+	}
+	
+	FDamageNumberEntry& Entry = PendingDamageNumbers.AddDefaulted_GetRef();
+	Entry.TargetCharacter = TargetCharacter;
+	Entry.DamageAmount = DamageAmount;
+	Entry.bEvadedHit = bEvadedHit;
+	Entry.bCriticalHit = bCriticalHit;
+	Entry.bBlockChance = bBlockChance;
+}
+
+void APlayerCharacterController::FlushDamageNumbers()
+{
+	if (PendingDamageNumbers.IsEmpty()) return;
+	
+	ClientShowDamageNumbers(PendingDamageNumbers);
+	PendingDamageNumbers.Reset();
+}
+
+void APlayerCharacterController::ClientShowDamageNumbers_Implementation(const TArray<FDamageNumberEntry>& DamageNumbers)
+{
+	for (const FDamageNumberEntry& DamageNumber : DamageNumbers)
+	{
+		RenderDamageNumber(DamageNumber);
+	}
+}
+
+void APlayerCharacterController::RenderDamageNumber(const FDamageNumberEntry& DamageNumber)
+{
+#if TOPDOWN_WITH_COSMETICS
+	ACharacter* TargetCharacter = DamageNumber.TargetCharacter;
 	if (IsValid(TargetCharacter) && DamageTextWidgetComponentClass)
 	{
-		UDamageTextWidgetComponent* DamageText = NewObject<UDamageTextWidgetComponent>(TargetCharacter, DamageTextWidgetComponentClass);
-		// After creating a component dynamically, we need to register it manually.
-		DamageText->RegisterComponent();
+		UDamageTextWidgetComponent* DamageText = AcquireDamageText(TargetCharacter);
+		// Reused components still carry the world transform of their last number, start again from the class default offset.
+		DamageText->SetRelativeTransform(DamageTextWidgetComponentClass->GetDefaultObject<UDamageTextWidgetComponent>()->GetRelativeTransform());
 		DamageText->AttachToComponent(TargetCharacter->GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
 		DamageText->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
-		DamageText->SetDamageText(DamageAmount, bEvadedHit, bCriticalHit, bBlockChance);
+		DamageText->ShowDamageText(this, DamageNumber.DamageAmount, DamageNumber.bEvadedHit, DamageNumber.bCriticalHit, DamageNumber.bBlockChance);
+	}
+#endif
+}
+
+UDamageTextWidgetComponent* APlayerCharacterController::AcquireDamageText(ACharacter* TargetCharacter)
+{
+	while (!DamageTextPool.IsEmpty())
+	{
+		// The owning actor of a pooled component may have been destroyed since it was released.
+		UDamageTextWidgetComponent* DamageText = DamageTextPool.Pop(EAllowShrinking::No);
+		if (IsValid(DamageText))
+		{
+			return DamageText;
+		}
 	}
+
+	/*
+	 * Pooled components outlive the character they were shown on, so they belong to our own pawn when we have one.
+	 * The controller itself is hidden and would hide them as well.
+	 */
+	AActor* DamageTextOwner = GetPawn() ? static_cast<AActor*>(GetPawn()) : TargetCharacter;
+	UDamageTextWidgetComponent* DamageText = NewObject<UDamageTextWidgetComponent>(DamageTextOwner, DamageTextWidgetComponentClass);
+	// After creating a component dynamically, we need to register it manually.
+	DamageText->RegisterComponent();
+	return DamageText;
 }
 
+void APlayerCharacterController::ReleaseDamageText(UDamageTextWidgetComponent* DamageText)
+{
+	if (!IsValid(DamageText)) return;
+	
+	if (DamageTextPool.Num() >= MaxPooledDamageTexts)
+	{
+		DamageText->DestroyComponent();
+		return;
+	}
+	DamageTextPool.Add(DamageText);
+}
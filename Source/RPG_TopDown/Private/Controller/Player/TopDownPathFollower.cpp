@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Controller/Player/TopDownPathFollower.h"
+
+void FTopDownPathFollower::SetPath(const TArray<FVector>& InPathPoints)
+{
+	PathPoints = InPathPoints;
+	SegmentIndex = 0;
+	SegmentAlpha = 0.f;
+}
+
+bool FTopDownPathFollower::Update(const FVector& Location, FVector& OutDirection)
+{
+	if (PathPoints.IsEmpty()) return false;
+
+	const FVector& Destination = PathPoints.Last();
+	if (FVector::DistSquared2D(Location, Destination) <= FMath::Square(AcceptanceRadius)) return false;
+
+	if (PathPoints.Num() == 1)
+	{
+		OutDirection = (Destination - Location).GetSafeNormal2D();
+		return true;
+	}
+
+	// Usually this stays on the current segment or steps one forward, it never goes back.
+	for (;;)
+	{
+		const FVector2D SegmentStart(PathPoints[SegmentIndex]);
+		const FVector2D SegmentEnd(PathPoints[SegmentIndex + 1]);
+		const FVector2D Segment = SegmentEnd - SegmentStart;
+		const float SegmentLengthSquared = Segment.SizeSquared();
+		const float Alpha = SegmentLengthSquared > UE_KINDA_SMALL_NUMBER
+			? FMath::Clamp(FVector2D::DotProduct(FVector2D(Location) - SegmentStart, Segment) / SegmentLengthSquared, 0.f, 1.f)
+			: 1.f;
+		SegmentAlpha = FMath::Max(SegmentAlpha, Alpha);
+
+		if (SegmentIndex >= GetLastSegmentIndex()) break;
+
+		const bool bCornerReached = SegmentAlpha >= 1.f ||
+			FVector::DistSquared2D(Location, PathPoints[SegmentIndex + 1]) <= FMath::Square(CornerTrimRadius);
+		if (!bCornerReached) break;
+
+		++SegmentIndex;
+		SegmentAlpha = 0.f;
+	}
+
+	OutDirection = (GetPointAhead(LookAheadDistance) - Location).GetSafeNormal2D();
+	if (OutDirection.IsNearlyZero())
+	{
+		OutDirection = (Destination - Location).GetSafeNormal2D();
+	}
+	return true;
+}
+
+FVector FTopDownPathFollower::GetPointAhead(float Distance) const
+{
+	int32 Index = SegmentIndex;
+	FVector Point = FMath::Lerp(PathPoints[Index], PathPoints[Index + 1], SegmentAlpha);
+	float RemainingDistance = Distance;
+
+	while (Index <= GetLastSegmentIndex())
+	{
+		const FVector& SegmentEnd = PathPoints[Index + 1];
+		const float DistanceToSegmentEnd = FVector::Dist2D(Point, SegmentEnd);
+		if (DistanceToSegmentEnd > RemainingDistance)
+		{
+			return FMath::Lerp(Point, SegmentEnd, RemainingDistance / DistanceToSegmentEnd);
+		}
+		RemainingDistance -= DistanceToSegmentEnd;
+		Point = SegmentEnd;
+		++Index;
+	}
+	return PathPoints.Last();
+}
@@ -10,21 +10,24 @@
 
 void UAttributeMenuWidgetController::BindCallbacksToDependencies()
 {
-	// Cast the AttributeSet to UBaseAttributeSet to access its methods.
-	const UBaseAttributeSet* BaseAttributeSet = CastChecked<UBaseAttributeSet>(AttributeSet);
-
 	// Check if the Data Asset for Attribute Info is valid in blueprint
 	check(AttributeInfoDataAsset);
+	InitializeAttributeTracking();
 
 	// Iterate over each attribute tag in the data asset and bind its change delegate.
-	for (const FTopDownAttributeInfo& Tag : AttributeInfoDataAsset.Get()->AttributeInformation)
+	const TArray<FTopDownAttributeInfo>& AttributeInformation = AttributeInfoDataAsset->AttributeInformation;
+	for (const FTopDownAttributeInfo& Info : AttributeInformation)
 	{
-		// Add a lambda function to the ability system component's attribute change delegate.
-		AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(Tag.AttributeGetter).AddLambda(
-		[this, &Tag, BaseAttributeSet] (const FOnAttributeChangeData& Data)
+		// Resolve the entry once here instead of searching the data asset on every change.
+		const int32 AttributeIndex = AttributeInfoDataAsset->FindAttributeInfoIndex(Info.AttributeTag);
+		
+		// Several attributes often change in the same frame (a primary attribute and everything derived from it),
+		// so changes are only marked here and broadcast together on the next tick.
+		AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(Info.AttributeGetter).AddWeakLambda(this,
+		[this, AttributeIndex] (const FOnAttributeChangeData& Data)
 			{
-				// Call the function to broadcast attribute info whenever an attribute changes.
-				BroadcastAttributeInfo(BaseAttributeSet, Tag);
+				PendingAttributes[AttributeIndex] = true;
+				RequestFlushNextTick();
 			}
 		);
 	}
@@ -33,26 +36,64 @@ void UAttributeMenuWidgetController::BindCallbacksToDependencies()
 // Broadcasts the initial values of attributes to the UI.
 void UAttributeMenuWidgetController::BroadcastInitialValues()
 {
-	// Cast the AttributeSet to UBaseAttributeSet to access its methods.
-	const UBaseAttributeSet* BaseAttributeSet = CastChecked<UBaseAttributeSet>(AttributeSet);
-
 	// Check if the Data Asset for Attribute Info is valid in blueprint
 	check(AttributeInfoDataAsset);
+	InitializeAttributeTracking();
+
+	// Iterate over each attribute in the data asset and broadcast its info, whether or not it changed.
+	TArray<FTopDownAttributeInfo> Batch;
+	for (int32 AttributeIndex = 0; AttributeIndex < AttributeInfoDataAsset->AttributeInformation.Num(); ++AttributeIndex)
+	{
+		BroadcastAttributeInfo(AttributeIndex, true, &Batch);
+	}
+	AttributeInfoBatchDelegate.Broadcast(Batch);
+}
+
+void UAttributeMenuWidgetController::FlushPendingBroadcasts()
+{
+	if (AttributeInfoDataAsset == nullptr) return;
+	
+	TArray<FTopDownAttributeInfo> Batch;
+	for (TConstSetBitIterator<> It(PendingAttributes); It; ++It)
+	{
+		BroadcastAttributeInfo(It.GetIndex(), false, &Batch);
+	}
+	PendingAttributes.SetRange(0, PendingAttributes.Num(), false);
 
-	// Iterate over each attribute tag in the data asset and broadcast its info.
-	for (const FTopDownAttributeInfo& Tag : AttributeInfoDataAsset.Get()->AttributeInformation)
+	if (Batch.Num() > 0)
 	{
-		BroadcastAttributeInfo(BaseAttributeSet, Tag);
+		AttributeInfoBatchDelegate.Broadcast(Batch);
 	}
 }
 
 // Helper function to broadcast attribute info to UI elements.
-void UAttributeMenuWidgetController::BroadcastAttributeInfo(const UAttributeSet* AS, const FTopDownAttributeInfo& Tag) const
+bool UAttributeMenuWidgetController::BroadcastAttributeInfo(int32 AttributeIndex, bool bForce, TArray<FTopDownAttributeInfo>* OutBatch)
 {
-	// Find the attribute info for the given tag from the data asset.
-	FTopDownAttributeInfo Info = AttributeInfoDataAsset->FindAttributeInfoForTag(Tag.AttributeTag);
-	// Set the attribute value from the attribute set.
-	Info.AttributeValue = Info.AttributeGetter.GetNumericValue(AttributeSet);
+	const FTopDownAttributeInfo& StoredInfo = AttributeInfoDataAsset->AttributeInformation[AttributeIndex];
+	const float AttributeValue = StoredInfo.AttributeGetter.GetNumericValue(AttributeSet);
+
+	// Changed back and forth within the frame, or set to the value it already had.
+	if (!bForce && AttributeValue == LastBroadcastValues[AttributeIndex]) return false;
+	LastBroadcastValues[AttributeIndex] = AttributeValue;
+
+	// Copy the info and set the attribute value from the attribute set.
+	FTopDownAttributeInfo Info = StoredInfo;
+	Info.AttributeValue = AttributeValue;
 	// Broadcast the updated attribute info.
 	AttributeInfoDelegate.Broadcast(Info);
+	if (OutBatch)
+	{
+		OutBatch->Add(MoveTemp(Info));
+	}
+	return true;
+}
+
+void UAttributeMenuWidgetController::InitializeAttributeTracking()
+{
+	const int32 NumAttributes = AttributeInfoDataAsset->AttributeInformation.Num();
+	if (LastBroadcastValues.Num() != NumAttributes)
+	{
+		LastBroadcastValues.Init(0.f, NumAttributes);
+		PendingAttributes.Init(false, NumAttributes);
+	}
 }
@@ -3,6 +3,9 @@
 
 #include "Controller/Widget/BaseWidgetController.h"
 
+#include "TimerManager.h"
+#include "GameFramework/PlayerController.h"
+
 
 /**
  * Sets the widget controller variables by copying the values from the provided FWidgetControllerVariables struct.
@@ -34,3 +37,44 @@ void UBaseWidgetController::BindCallbacksToDependencies()
 {
 	
 }
+
+void UBaseWidgetController::RequestFlushNextTick()
+{
+	RequestFlush(0.f);
+}
+
+void UBaseWidgetController::RequestFlush(float MinInterval)
+{
+	if (bFlushRequested) return;
+
+	UWorld* World = PlayerController ? PlayerController->GetWorld() : nullptr;
+	if (World == nullptr)
+	{
+		// Nothing to schedule on, don't hold the update back.
+		FlushPendingBroadcasts();
+		return;
+	}
+
+	bFlushRequested = true;
+	const double Delay = MinInterval > 0.f ? LastFlushTime + MinInterval - World->GetTimeSeconds() : 0.0;
+	if (Delay > 0.0)
+	{
+		World->GetTimerManager().SetTimer(FlushTimerHandle, FTimerDelegate::CreateUObject(this, &UBaseWidgetController::OnFlushTimer), Delay, false);
+	}
+	else
+	{
+		World->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &UBaseWidgetController::OnFlushTimer));
+	}
+}
+
+void UBaseWidgetController::OnFlushTimer()
+{
+	bFlushRequested = false;
+	LastFlushTime = PlayerController ? PlayerController->GetWorld()->GetTimeSeconds() : 0.0;
+	FlushPendingBroadcasts();
+}
+
+void UBaseWidgetController::FlushPendingBroadcasts()
+{
+	
+}
@@ -5,6 +5,14 @@
 
 #include "AbilitySystem/BaseAbilitySystemComponent.h"
 #include "AbilitySystem/BaseAttributeSet.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Suppressed Vital Broadcasts"), STAT_SuppressedVitalBroadcasts, STATGROUP_TopDown);
+
+static TAutoConsoleVariable<float> CVarVitalUpdateRate(
+	TEXT("TopDown.UI.VitalUpdateRate"),
+	0.f,
+	TEXT("Most overlay vital attribute updates per second. 0 updates once per frame with whatever changed."));
 
 
 // Broadcasts the initial values of the attributes when the widget is first initialized.
@@ -27,6 +35,15 @@ void UOverlayWidgetController::BroadcastInitialValues()
 	OnStaminaChanged.Broadcast(BaseAttributeSet->GetStamina());
 	// Broadcast the initial max stamina value.
 	OnMaxStaminaChanged.Broadcast(BaseAttributeSet->GetMaxStamina());
+
+	// And all of them at once.
+	PendingVitals.Health = BaseAttributeSet->GetHealth();
+	PendingVitals.MaxHealth = BaseAttributeSet->GetMaxHealth();
+	PendingVitals.Mana = BaseAttributeSet->GetMana();
+	PendingVitals.MaxMana = BaseAttributeSet->GetMaxMana();
+	PendingVitals.Stamina = BaseAttributeSet->GetStamina();
+	PendingVitals.MaxStamina = BaseAttributeSet->GetMaxStamina();
+	OnVitalAttributesChanged.Broadcast(PendingVitals);
 }
 
 // Function to set up the binding of attribute change callbacks
@@ -71,11 +88,14 @@ void UOverlayWidgetController::BindVitalAttributeChangeCallbacks(const UBaseAttr
 	 * So if you want to call a member function in a lambda, you have to capture that object of the class that that function belongs to.
 	 */
 	
+	// Regen and multi hit damage can change a vital many times per frame, so the callbacks only record the value
+	// and the widgets get one update per frame (or per TopDown.UI.VitalUpdateRate) from FlushPendingBroadcasts.
+	
 	// Bind callback for health attribute changes.
 	AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(BaseAttributeSet->GetHealthAttribute()).AddLambda(
 		[this](const FOnAttributeChangeData& Data)
 		{
-			OnHealthChanged.Broadcast(Data.NewValue);
+			MarkVitalDirty(EVitalAttribute::Health, Data.NewValue);
 		}
 	);
 
@@ -84,7 +104,7 @@ void UOverlayWidgetController::BindVitalAttributeChangeCallbacks(const UBaseAttr
 	AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(BaseAttributeSet->GetMaxHealthAttribute()).AddLambda(
 		[this](const FOnAttributeChangeData& Data)
 		{
-			OnMaxHealthChanged.Broadcast(Data.NewValue);
+			MarkVitalDirty(EVitalAttribute::MaxHealth, Data.NewValue);
 		}
 	);
 
@@ -92,7 +112,7 @@ void UOverlayWidgetController::BindVitalAttributeChangeCallbacks(const UBaseAttr
 	AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(BaseAttributeSet->GetManaAttribute()).AddLambda(
 		[this](const FOnAttributeChangeData& Data)
 		{
-			OnManaChanged.Broadcast(Data.NewValue);
+			MarkVitalDirty(EVitalAttribute::Mana, Data.NewValue);
 		}
 	);
 
@@ -101,7 +121,7 @@ void UOverlayWidgetController::BindVitalAttributeChangeCallbacks(const UBaseAttr
 	AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(BaseAttributeSet->GetMaxManaAttribute()).AddLambda(
 		[this](const FOnAttributeChangeData& Data)
 		{
-			OnMaxManaChanged.Broadcast(Data.NewValue);
+			MarkVitalDirty(EVitalAttribute::MaxMana, Data.NewValue);
 		}
 	);
 	
@@ -109,7 +129,7 @@ void UOverlayWidgetController::BindVitalAttributeChangeCallbacks(const UBaseAttr
 	AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(BaseAttributeSet->GetStaminaAttribute()).AddLambda(
 		[this](const FOnAttributeChangeData& Data)
 		{
-			OnStaminaChanged.Broadcast(Data.NewValue);
+			MarkVitalDirty(EVitalAttribute::Stamina, Data.NewValue);
 		}
 	);
 	
@@ -117,11 +137,53 @@ void UOverlayWidgetController::BindVitalAttributeChangeCallbacks(const UBaseAttr
 	AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(BaseAttributeSet->GetMaxStaminaAttribute()).AddLambda(
 		[this](const FOnAttributeChangeData& Data)
 		{
-			OnMaxStaminaChanged.Broadcast(Data.NewValue);
+			MarkVitalDirty(EVitalAttribute::MaxStamina, Data.NewValue);
 		}
 	);
 }
 
+void UOverlayWidgetController::MarkVitalDirty(EVitalAttribute Vital, float NewValue)
+{
+	switch (Vital)
+	{
+	case EVitalAttribute::Health:		PendingVitals.Health = NewValue; break;
+	case EVitalAttribute::MaxHealth:	PendingVitals.MaxHealth = NewValue; break;
+	case EVitalAttribute::Mana:			PendingVitals.Mana = NewValue; break;
+	case EVitalAttribute::MaxMana:		PendingVitals.MaxMana = NewValue; break;
+	case EVitalAttribute::Stamina:		PendingVitals.Stamina = NewValue; break;
+	case EVitalAttribute::MaxStamina:	PendingVitals.MaxStamina = NewValue; break;
+	default: return;
+	}
+
+	const uint8 VitalBit = 1 << static_cast<uint8>(Vital);
+	if (DirtyVitals & VitalBit)
+	{
+		// Already pending, this change replaces the earlier value instead of being broadcast on its own.
+		++NumSuppressedVitalBroadcasts;
+		INC_DWORD_STAT(STAT_SuppressedVitalBroadcasts);
+	}
+	DirtyVitals |= VitalBit;
+
+	const float UpdateRate = CVarVitalUpdateRate.GetValueOnGameThread();
+	RequestFlush(UpdateRate > 0.f ? 1.f / UpdateRate : 0.f);
+}
+
+void UOverlayWidgetController::FlushPendingBroadcasts()
+{
+	if (DirtyVitals == 0) return;
+
+	const auto IsDirty = [this](EVitalAttribute Vital) { return (DirtyVitals & (1 << static_cast<uint8>(Vital))) != 0; };
+	if (IsDirty(EVitalAttribute::Health)) OnHealthChanged.Broadcast(PendingVitals.Health);
+	if (IsDirty(EVitalAttribute::MaxHealth)) OnMaxHealthChanged.Broadcast(PendingVitals.MaxHealth);
+	if (IsDirty(EVitalAttribute::Mana)) OnManaChanged.Broadcast(PendingVitals.Mana);
+	if (IsDirty(EVitalAttribute::MaxMana)) OnMaxManaChanged.Broadcast(PendingVitals.MaxMana);
+	if (IsDirty(EVitalAttribute::Stamina)) OnStaminaChanged.Broadcast(PendingVitals.Stamina);
+	if (IsDirty(EVitalAttribute::MaxStamina)) OnMaxStaminaChanged.Broadcast(PendingVitals.MaxStamina);
+	DirtyVitals = 0;
+
+	OnVitalAttributesChanged.Broadcast(PendingVitals);
+}
+
 // Function to bind GameplayEffectAssetTags to a lambda function
 void UOverlayWidgetController::BindGameplayEffectTagMessages()
 {
@@ -150,6 +212,9 @@ void UOverlayWidgetController::BindGameplayEffectTagMessages()
 	 * Now we can capture variables, we can capture things by reference, we can capture things by pointer.
 	 * So if you want to call a member function in a lambda, you have to capture that object of the class that that function belongs to.
 	 */
+	// Resolve the message tags and rows once, the lambda below runs for every applied effect.
+	BuildMessageRowCache();
+	
 	// Cast to UBaseAbilitySystemComponent and bind a lambda to the GameplayEffectAssetTags delegate
 	Cast<UBaseAbilitySystemComponent>(AbilitySystemComponent)->GameplayEffectAssetTags.AddLambda(
 		[this](const FGameplayTagContainer& AssetTags)
@@ -159,13 +224,11 @@ void UOverlayWidgetController::BindGameplayEffectTagMessages()
 			{
 				// For example, say that Tag = Message.HealthPotion
 				// "Message.HealthPotion".MatchesTag("Message") will return True, "Message".MatchesTag("Message.HealthPotion") will return False
-				FGameplayTag MessageTag = FGameplayTag::RequestGameplayTag(FName("Message"));
-				if (Tag.MatchesTag(MessageTag))
+				if (Tag.MatchesTag(MessageParentTag))
 				{
-					const FGameplayTagMessageInfoRow* MessageInfoRow = GetDataTableRowByTag<FGameplayTagMessageInfoRow>(GameplayTagToUIMessageDataTable, Tag);
-					if (MessageInfoRow)
+					if (const FGameplayTagMessageInfoRow* const* MessageInfoRow = MessageRowsByTag.Find(Tag))
 					{
-						GameplayTagMessageInfoRowDelegate.Broadcast(*MessageInfoRow);
+						GameplayTagMessageInfoRowDelegate.Broadcast(**MessageInfoRow);
 					}
 					//const FString Msg = FString::Printf(TEXT("GE Tag: %s"), *Tag.ToString());
 					//GEngine->AddOnScreenDebugMessage(-1, 15.f, FColor::Blue, Msg);
@@ -174,3 +237,22 @@ void UOverlayWidgetController::BindGameplayEffectTagMessages()
 		}
 	);
 }
+
+// Compiles the message data table into a tag keyed map of row pointers.
+void UOverlayWidgetController::BuildMessageRowCache()
+{
+	MessageParentTag = FGameplayTag::RequestGameplayTag(FName("Message"));
+	MessageRowsByTag.Reset();
+	if (GameplayTagToUIMessageDataTable == nullptr) return;
+
+	// Rows are named after their tag, the same key GetDataTableRowByTag looks them up by.
+	GameplayTagToUIMessageDataTable->ForeachRow<FGameplayTagMessageInfoRow>(TEXT("BuildMessageRowCache"),
+		[this](const FName& RowName, const FGameplayTagMessageInfoRow& Row)
+		{
+			const FGameplayTag RowTag = FGameplayTag::RequestGameplayTag(RowName, false);
+			if (RowTag.IsValid())
+			{
+				MessageRowsByTag.Add(RowTag, &Row);
+			}
+		});
+}
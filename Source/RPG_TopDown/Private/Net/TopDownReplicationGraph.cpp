@@ -0,0 +1,378 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Net/TopDownReplicationGraph.h"
+
+#include "ReplicationGraphNodes.h"
+#include "Actor/TopDownProjectile.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Replication Graph Replicate Actors"), STAT_TopDownRepGraphReplicateActors, STATGROUP_TopDown);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replication Graph Connections"), STAT_TopDownRepGraphConnections, STATGROUP_TopDown);
+
+static TAutoConsoleVariable<float> CVarRepGraphCellSize(
+	TEXT("TopDown.RepGraph.CellSize"),
+	10000.f,
+	TEXT("Size of a spatial grid cell in cm. Read when the replication graph is created."));
+
+static TAutoConsoleVariable<bool> CVarRepGraphFrequencyBuckets(
+	TEXT("TopDown.RepGraph.FrequencyBuckets"),
+	true,
+	TEXT("Replicate spatialized actors at a per connection rate that drops with distance. Read when the replication graph is created."));
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorldAndArgs CRepGraphReport(
+	TEXT("TopDown.RepGraph.Report"),
+	TEXT("Logs the time the replication graph spent replicating actors, per frame and per connection. Pass reset to start over."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		UTopDownReplicationGraph* ReplicationGraph = NetDriver ? Cast<UTopDownReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+		if (ReplicationGraph == nullptr)
+		{
+			UE_LOG(LogTemp, Display, TEXT("No TopDown replication graph on this world's net driver."));
+			return;
+		}
+
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			ReplicationGraph->ResetReplicationTiming();
+			return;
+		}
+		ReplicationGraph->LogReplicationTiming();
+	}));
+#endif
+
+void UTopDownReplicationGraphNode_OwnerRelevant::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		ReplicationActorList.ConditionalAdd(Viewer.InViewer);
+		ReplicationActorList.ConditionalAdd(Viewer.ViewTarget);
+
+		if (const APlayerController* PlayerController = Cast<APlayerController>(Viewer.InViewer))
+		{
+			ReplicationActorList.ConditionalAdd(PlayerController->PlayerState);
+		}
+	}
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+
+	if (OwnedActorList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(OwnedActorList);
+	}
+}
+
+void UTopDownReplicationGraphNode_OwnerRelevant::AddOwnedActor(AActor* Actor)
+{
+	OwnedActorList.ConditionalAdd(Actor);
+}
+
+void UTopDownReplicationGraphNode_OwnerRelevant::RemoveOwnedActor(AActor* Actor)
+{
+	OwnedActorList.RemoveFast(Actor);
+}
+
+void UTopDownReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		const UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if (ActorCDO == nullptr || !ActorCDO->GetIsReplicated()) continue;
+
+		// Leftovers of blueprint compilation.
+		const FString ClassName = Class->GetName();
+		if (ClassName.StartsWith(TEXT("SKEL_")) || ClassName.StartsWith(TEXT("REINST_"))) continue;
+
+		const ETopDownClassNodeMapping Policy = GetMappingPolicy(Class);
+		const bool bSpatialize = Policy == ETopDownClassNodeMapping::SpatializeStatic ||
+			Policy == ETopDownClassNodeMapping::SpatializeDynamic ||
+			Policy == ETopDownClassNodeMapping::SpatializeDormancy;
+
+		FClassReplicationInfo ClassInfo;
+		InitClassReplicationInfo(ClassInfo, Class, bSpatialize);
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UTopDownReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = CVarRepGraphCellSize.GetValueOnGameThread();
+	GridNode->SpatialBias = FVector2D(-UE_OLD_WORLD_MAX, -UE_OLD_WORLD_MAX);
+	AddGlobalGraphNode(GridNode);
+
+	if (CVarRepGraphFrequencyBuckets.GetValueOnGameThread())
+	{
+		UReplicationGraphNode_GridCell::CreateDynamicNodeOverride = [](UReplicationGraphNode_GridCell* Parent)
+		{
+			return Parent->CreateChildNode<UReplicationGraphNode_DynamicSpatialFrequency>();
+		};
+	}
+	else
+	{
+		UReplicationGraphNode_GridCell::CreateDynamicNodeOverride = nullptr;
+	}
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	PlayerStateNode = CreateNewNode<UReplicationGraphNode_PlayerStateFrequencyLimiter>();
+	AddGlobalGraphNode(PlayerStateNode);
+}
+
+void UTopDownReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UTopDownReplicationGraphNode_OwnerRelevant* OwnerRelevantNode = CreateNewNode<UTopDownReplicationGraphNode_OwnerRelevant>();
+	AddConnectionGraphNode(OwnerRelevantNode, RepGraphConnection);
+	OwnerRelevantNodes.Add(TObjectKey<UNetReplicationGraphConnection>(RepGraphConnection), OwnerRelevantNode);
+}
+
+void UTopDownReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case ETopDownClassNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case ETopDownClassNodeMapping::SpatializeStatic:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case ETopDownClassNodeMapping::SpatializeDynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case ETopDownClassNodeMapping::SpatializeDormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	case ETopDownClassNodeMapping::OwnerRelevant:
+		UpdateOwnerRelevantActor(ActorInfo.Actor, OwnerRelevantActors.Add(TObjectKey<AActor>(ActorInfo.Actor)));
+		break;
+	// The player state frequency limiter finds player states on its own.
+	case ETopDownClassNodeMapping::PlayerState:
+	case ETopDownClassNodeMapping::NotRouted:
+		break;
+	}
+}
+
+void UTopDownReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case ETopDownClassNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case ETopDownClassNodeMapping::SpatializeStatic:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case ETopDownClassNodeMapping::SpatializeDynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case ETopDownClassNodeMapping::SpatializeDormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	case ETopDownClassNodeMapping::OwnerRelevant:
+		if (const TWeakObjectPtr<UNetReplicationGraphConnection>* RoutedConnection = OwnerRelevantActors.Find(TObjectKey<AActor>(ActorInfo.Actor)))
+		{
+			if (UTopDownReplicationGraphNode_OwnerRelevant* OwnerRelevantNode = FindOwnerRelevantNode(RoutedConnection->Get()))
+			{
+				OwnerRelevantNode->RemoveOwnedActor(ActorInfo.Actor);
+			}
+			OwnerRelevantActors.Remove(TObjectKey<AActor>(ActorInfo.Actor));
+		}
+		break;
+	case ETopDownClassNodeMapping::PlayerState:
+	case ETopDownClassNodeMapping::NotRouted:
+		break;
+	}
+}
+
+void UTopDownReplicationGraph::RemoveClientConnection(UNetConnection* NetConnection)
+{
+	for (const UNetReplicationGraphConnection* ConnectionManager : Connections)
+	{
+		if (ConnectionManager && ConnectionManager->NetConnection == NetConnection)
+		{
+			OwnerRelevantNodes.Remove(TObjectKey<UNetReplicationGraphConnection>(ConnectionManager));
+		}
+	}
+
+	Super::RemoveClientConnection(NetConnection);
+}
+
+int32 UTopDownReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TopDownRepGraphReplicateActors);
+
+	// There is no notification for SetOwner, so owner only actors are checked here. There are only a handful of them.
+	for (TPair<TObjectKey<AActor>, TWeakObjectPtr<UNetReplicationGraphConnection>>& OwnerRelevantActor : OwnerRelevantActors)
+	{
+		if (AActor* Actor = OwnerRelevantActor.Key.ResolveObjectPtr())
+		{
+			UpdateOwnerRelevantActor(Actor, OwnerRelevantActor.Value);
+		}
+	}
+
+	const int32 NumConnections = NetDriver ? NetDriver->ClientConnections.Num() : 0;
+	SET_DWORD_STAT(STAT_TopDownRepGraphConnections, NumConnections);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const int32 NumReplicated = Super::ServerReplicateActors(DeltaSeconds);
+	const uint64 FrameCycles = FPlatformTime::Cycles64() - StartCycles;
+
+	ReplicateActorsCycles += FrameCycles;
+	ReplicateActorsMaxCycles = FMath::Max(ReplicateActorsMaxCycles, FrameCycles);
+	++ReplicateActorsFrames;
+	ConnectionFrames += NumConnections;
+	MaxConnections = FMath::Max(MaxConnections, NumConnections);
+
+	return NumReplicated;
+}
+
+void UTopDownReplicationGraph::SetActorNetUpdateFrequency(AActor* Actor, float NetUpdateFrequency)
+{
+	const uint16 ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(NetUpdateFrequency);
+	if (FGlobalActorReplicationInfo* GlobalInfo = GlobalActorReplicationInfoMap.Find(Actor))
+	{
+		GlobalInfo->Settings.ReplicationPeriodFrame = ReplicationPeriodFrame;
+	}
+
+	// Every connection copied the period when it first saw the actor and only reads its own copy from then on.
+	for (UNetReplicationGraphConnection* ConnectionManager : Connections)
+	{
+		FConnectionReplicationActorInfo* ConnectionActorInfo = ConnectionManager ? ConnectionManager->ActorInfoMap.Find(Actor) : nullptr;
+		if (ConnectionActorInfo == nullptr) continue;
+
+		ConnectionActorInfo->ReplicationPeriodFrame = ReplicationPeriodFrame;
+		// Going from idle to active should not wait out the rest of the idle period.
+		ConnectionActorInfo->NextReplicationFrameNum = FMath::Min(ConnectionActorInfo->NextReplicationFrameNum, GetReplicationGraphFrame() + ReplicationPeriodFrame);
+	}
+}
+
+void UTopDownReplicationGraph::LogActorReplicationPeriod(AActor* Actor)
+{
+	const FGlobalActorReplicationInfo* GlobalInfo = GlobalActorReplicationInfoMap.Find(Actor);
+	UE_LOG(LogTemp, Display, TEXT("  Replication graph: every %d frames globally"), GlobalInfo ? static_cast<int32>(GlobalInfo->Settings.ReplicationPeriodFrame) : -1);
+
+	for (const UNetReplicationGraphConnection* ConnectionManager : Connections)
+	{
+		if (const FConnectionReplicationActorInfo* ConnectionActorInfo = ConnectionManager ? ConnectionManager->ActorInfoMap.Find(Actor) : nullptr)
+		{
+			UE_LOG(LogTemp, Display, TEXT("  %s: every %d frames"),
+				*GetNameSafe(ConnectionManager->NetConnection), static_cast<int32>(ConnectionActorInfo->ReplicationPeriodFrame));
+		}
+	}
+}
+
+void UTopDownReplicationGraph::ResetReplicationTiming()
+{
+	ReplicateActorsCycles = 0;
+	ReplicateActorsMaxCycles = 0;
+	ReplicateActorsFrames = 0;
+	ConnectionFrames = 0;
+	MaxConnections = 0;
+}
+
+void UTopDownReplicationGraph::LogReplicationTiming() const
+{
+	const double TotalMs = FPlatformTime::ToMilliseconds64(ReplicateActorsCycles);
+	UE_LOG(LogTemp, Display, TEXT("Replication graph: %u frames, up to %d connections. %.3f ms per frame (max %.3f), %.4f ms per connection frame."),
+		ReplicateActorsFrames, MaxConnections,
+		ReplicateActorsFrames > 0 ? TotalMs / ReplicateActorsFrames : 0.0,
+		FPlatformTime::ToMilliseconds64(ReplicateActorsMaxCycles),
+		ConnectionFrames > 0 ? TotalMs / ConnectionFrames : 0.0);
+}
+
+void UTopDownReplicationGraph::UpdateOwnerRelevantActor(AActor* Actor, TWeakObjectPtr<UNetReplicationGraphConnection>& RoutedConnection)
+{
+	UNetConnection* NetConnection = Actor->GetNetConnection();
+	UNetReplicationGraphConnection* ConnectionManager = NetConnection ? FindOrAddConnectionManager(NetConnection) : nullptr;
+	if (ConnectionManager == RoutedConnection.Get()) return;
+
+	if (UTopDownReplicationGraphNode_OwnerRelevant* OldNode = FindOwnerRelevantNode(RoutedConnection.Get()))
+	{
+		OldNode->RemoveOwnedActor(Actor);
+	}
+
+	UTopDownReplicationGraphNode_OwnerRelevant* NewNode = FindOwnerRelevantNode(ConnectionManager);
+	if (NewNode)
+	{
+		NewNode->AddOwnedActor(Actor);
+	}
+	// Without a node yet, try again next frame.
+	RoutedConnection = NewNode ? ConnectionManager : nullptr;
+}
+
+UTopDownReplicationGraphNode_OwnerRelevant* UTopDownReplicationGraph::FindOwnerRelevantNode(const UNetReplicationGraphConnection* ConnectionManager) const
+{
+	if (ConnectionManager == nullptr) return nullptr;
+
+	const TWeakObjectPtr<UTopDownReplicationGraphNode_OwnerRelevant>* OwnerRelevantNode = OwnerRelevantNodes.Find(TObjectKey<UNetReplicationGraphConnection>(ConnectionManager));
+	return OwnerRelevantNode ? OwnerRelevantNode->Get() : nullptr;
+}
+
+ETopDownClassNodeMapping UTopDownReplicationGraph::GetMappingPolicy(const UClass* Class)
+{
+	if (const ETopDownClassNodeMapping* Policy = ClassMappingPolicies.Find(TObjectKey<UClass>(Class)))
+	{
+		return *Policy;
+	}
+
+	ETopDownClassNodeMapping Policy = ETopDownClassNodeMapping::NotRouted;
+	const AActor* ActorCDO = Class ? Cast<AActor>(Class->GetDefaultObject(false)) : nullptr;
+	if (ActorCDO == nullptr || !ActorCDO->GetIsReplicated())
+	{
+		Policy = ETopDownClassNodeMapping::NotRouted;
+	}
+	else if (Class->IsChildOf<APlayerState>())
+	{
+		Policy = ETopDownClassNodeMapping::PlayerState;
+	}
+	else if (ActorCDO->bAlwaysRelevant || Class->IsChildOf<AGameStateBase>())
+	{
+		Policy = ETopDownClassNodeMapping::RelevantAllConnections;
+	}
+	else if (Class->IsChildOf<APlayerController>())
+	{
+		Policy = ETopDownClassNodeMapping::NotRouted;
+	}
+	else if (ActorCDO->bOnlyRelevantToOwner)
+	{
+		Policy = ETopDownClassNodeMapping::OwnerRelevant;
+	}
+	else if (Class->IsChildOf<ATopDownProjectile>())
+	{
+		Policy = ETopDownClassNodeMapping::SpatializeDormancy;
+	}
+	else if (ActorCDO->GetRootComponent() && ActorCDO->GetRootComponent()->Mobility == EComponentMobility::Static)
+	{
+		Policy = ETopDownClassNodeMapping::SpatializeStatic;
+	}
+	else
+	{
+		Policy = ETopDownClassNodeMapping::SpatializeDynamic;
+	}
+
+	ClassMappingPolicies.Add(TObjectKey<UClass>(Class), Policy);
+	return Policy;
+}
+
+void UTopDownReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& ClassInfo, const UClass* Class, bool bSpatialize) const
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+	if (bSpatialize)
+	{
+		ClassInfo.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+	}
+	ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->NetUpdateFrequency);
+}
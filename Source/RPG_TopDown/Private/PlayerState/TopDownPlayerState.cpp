@@ -6,7 +6,39 @@
 #include "AbilitySystemComponent.h"
 #include "AbilitySystem/BaseAbilitySystemComponent.h"
 #include "AbilitySystem/BaseAttributeSet.h"
+#include "EngineUtils.h"
+#include "Engine/NetDriver.h"
+#include "Net/TopDownReplicationGraph.h"
 #include "Net/UnrealNetwork.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Player State Replication Checks Skipped"), STAT_PlayerStateReplicationChecksSkipped, STATGROUP_TopDown);
+
+static TAutoConsoleVariable<bool> CVarAdaptiveNetUpdateFrequency(
+    TEXT("TopDown.PlayerState.AdaptiveNetUpdate"),
+    true,
+    TEXT("Drop idle player states to their idle net update frequency. When off they always replicate at the active rate."));
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorld CPlayerStateNetReport(
+    TEXT("TopDown.PlayerState.NetReport"),
+    TEXT("Logs the current net update frequency and the performed and skipped replication checks of every player state.\n")
+    TEXT("Under the replication graph it also logs the period the graph uses for each connection."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+        UTopDownReplicationGraph* ReplicationGraph = NetDriver ? Cast<UTopDownReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+        for (TActorIterator<ATopDownPlayerState> It(World); It; ++It)
+        {
+            UE_LOG(LogTemp, Display, TEXT("%s: %.1f Hz, %u replication checks, %u skipped"),
+                *It->GetPlayerName(), It->NetUpdateFrequency, It->GetReplicationChecks(), It->GetSkippedReplicationChecks());
+            if (ReplicationGraph)
+            {
+                ReplicationGraph->LogActorReplicationPeriod(*It);
+            }
+        }
+    }));
+#endif
 
 ATopDownPlayerState::ATopDownPlayerState()
 {
@@ -14,8 +46,10 @@ ATopDownPlayerState::ATopDownPlayerState()
     /* This sets the frequency at which this actor's network updates are sent to the clients.
      * Higher values mean more frequent updates, which can improve the accuracy of the data at the cost of increased network traffic.
      * A value of 100 is quite high, which means updates are sent frequently.
+     * The ASC and attribute set live here, so we only run at that rate while they change, see MarkNetActivity.
      */
-    NetUpdateFrequency = 100.f;
+    NetUpdateFrequency = ActiveNetUpdateFrequency;
+    MinNetUpdateFrequency = IdleNetUpdateFrequency;
 
     // Create and initialize the AbilitySystemComponent
     AbilitySystemComponent = CreateDefaultSubobject<UBaseAbilitySystemComponent>("AbilitySystemComponent");
@@ -137,6 +171,82 @@ void ATopDownPlayerState::OnRep_Level(int32 OldLevel)
     
 }
 
+void ATopDownPlayerState::BeginPlay()
+{
+    Super::BeginPlay();
+
+    LastReplicationCheckTime = GetWorld()->GetTimeSeconds();
+    // Start active, the startup abilities and attributes are about to replicate.
+    MarkNetActivity();
+}
+
+void ATopDownPlayerState::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+    Super::PreReplication(ChangedPropertyTracker);
+
+    // Checks the active rate would have made since the last one we actually got.
+    // The server never considers an actor more often than it ticks, so the active rate is capped by its tick rate.
+    const UNetDriver* NetDriver = GetNetDriver();
+    const float BaselineFrequency = NetDriver ? FMath::Min(ActiveNetUpdateFrequency, static_cast<float>(NetDriver->NetServerMaxTickRate)) : ActiveNetUpdateFrequency;
+    const double Now = GetWorld()->GetTimeSeconds();
+    const int32 ExpectedChecks = FMath::FloorToInt32((Now - LastReplicationCheckTime) * BaselineFrequency);
+    LastReplicationCheckTime = Now;
+
+    ++ReplicationChecks;
+    if (ExpectedChecks > 1)
+    {
+        SkippedReplicationChecks += ExpectedChecks - 1;
+        INC_DWORD_STAT_BY(STAT_PlayerStateReplicationChecksSkipped, ExpectedChecks - 1);
+    }
+}
+
+void ATopDownPlayerState::MarkNetActivity()
+{
+    if (!HasAuthority()) return;
+
+    if (!CVarAdaptiveNetUpdateFrequency.GetValueOnGameThread())
+    {
+        if (NetUpdateFrequency != ActiveNetUpdateFrequency)
+        {
+            ApplyNetUpdateFrequency(ActiveNetUpdateFrequency);
+        }
+        return;
+    }
+
+    // Called for every attribute change, so this only stamps the time. The idle timer looks at it when it fires.
+    LastNetActivityTime = GetWorld()->GetTimeSeconds();
+    if (bNetActive) return;
+
+    bNetActive = true;
+    ApplyNetUpdateFrequency(ActiveNetUpdateFrequency);
+    GetWorldTimerManager().SetTimer(NetIdleTimerHandle, this, &ATopDownPlayerState::CheckNetIdle, FMath::Max(IdleNetUpdateDelay, 0.1f), false);
+}
+
+void ATopDownPlayerState::CheckNetIdle()
+{
+    const double IdleTime = GetWorld()->GetTimeSeconds() - LastNetActivityTime;
+    if (IdleTime < IdleNetUpdateDelay)
+    {
+        GetWorldTimerManager().SetTimer(NetIdleTimerHandle, this, &ATopDownPlayerState::CheckNetIdle, FMath::Max(IdleNetUpdateDelay - IdleTime, 0.1), false);
+        return;
+    }
+
+    bNetActive = false;
+    ApplyNetUpdateFrequency(IdleNetUpdateFrequency);
+}
+
+void ATopDownPlayerState::ApplyNetUpdateFrequency(const float NewNetUpdateFrequency)
+{
+    NetUpdateFrequency = NewNetUpdateFrequency;
+
+    // The replication graph copies the rate when the actor is added, so it has to be told as well.
+    const UNetDriver* NetDriver = GetNetDriver();
+    if (UTopDownReplicationGraph* ReplicationGraph = NetDriver ? Cast<UTopDownReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr)
+    {
+        ReplicationGraph->SetActorNetUpdateFrequency(this, NewNetUpdateFrequency);
+    }
+}
+
 // Get the Ability System Component associated with this player state
 //@return Pointer to the UAbilitySystemComponent
 UAbilitySystemComponent* ATopDownPlayerState::GetAbilitySystemComponent() const
@@ -0,0 +1,254 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystem/TopDownAttributeStoreSubsystem.h"
+
+#include "AbilitySystemComponent.h"
+#include "AbilitySystem/BaseAttributeSet.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Attribute Store Entries"), STAT_AttributeStoreEntries, STATGROUP_TopDown);
+
+static TAutoConsoleVariable<bool> CVarAttributeStoreEnabled(
+	TEXT("TopDown.AttributeStore.Enabled"),
+	false,
+	TEXT("Mirror the hot combat attributes of enemies into the world attribute store. Off by default, read when an enemy registers."));
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithArgs CAttributeStoreBenchmark(
+	TEXT("TopDown.AttributeStore.Benchmark"),
+	TEXT("Times a pass over <Count> (default 10000) enemies' Health, MaxHealth and Armor, once through attribute set objects and once through the attribute store."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Count = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+		constexpr int32 Passes = 100;
+
+		// Same data both ways. The attribute sets are separate heap objects like they are on real enemies.
+		TArray<UBaseAttributeSet*> AttributeSets;
+		AttributeSets.Reserve(Count);
+		FTopDownAttributeStore Store;
+		Store.Reserve(Count);
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			const float Health = FMath::FRandRange(0.f, 100.f);
+			const float Armor = FMath::FRandRange(0.f, 50.f);
+
+			UBaseAttributeSet* AttributeSet = NewObject<UBaseAttributeSet>(GetTransientPackage());
+			AttributeSet->InitHealth(Health);
+			AttributeSet->InitMaxHealth(100.f);
+			AttributeSet->InitArmor(Armor);
+			AttributeSets.Add(AttributeSet);
+
+			const FTopDownAttributeHandle Handle = Store.Allocate();
+			Store.SetValue(Handle, ETopDownStoredAttribute::Health, Health);
+			Store.SetValue(Handle, ETopDownStoredAttribute::MaxHealth, 100.f);
+			Store.SetValue(Handle, ETopDownStoredAttribute::Armor, Armor);
+		}
+
+		// Typical AoE question: how many are below half health, and how much armor do they have between them.
+		int32 AttributeSetWounded = 0;
+		float AttributeSetArmor = 0.f;
+		const double AttributeSetStart = FPlatformTime::Seconds();
+		for (int32 Pass = 0; Pass < Passes; ++Pass)
+		{
+			AttributeSetWounded = 0;
+			AttributeSetArmor = 0.f;
+			for (const UBaseAttributeSet* AttributeSet : AttributeSets)
+			{
+				if (AttributeSet->GetHealth() < AttributeSet->GetMaxHealth() * 0.5f)
+				{
+					++AttributeSetWounded;
+					AttributeSetArmor += AttributeSet->GetArmor();
+				}
+			}
+		}
+		const double AttributeSetSeconds = FPlatformTime::Seconds() - AttributeSetStart;
+
+		int32 StoreWounded = 0;
+		float StoreArmor = 0.f;
+		const TConstArrayView<float> Healths = Store.GetValues(ETopDownStoredAttribute::Health);
+		const TConstArrayView<float> MaxHealths = Store.GetValues(ETopDownStoredAttribute::MaxHealth);
+		const TConstArrayView<float> Armors = Store.GetValues(ETopDownStoredAttribute::Armor);
+		const double StoreStart = FPlatformTime::Seconds();
+		for (int32 Pass = 0; Pass < Passes; ++Pass)
+		{
+			StoreWounded = 0;
+			StoreArmor = 0.f;
+			// Every slot is alive here, so the dead slot check is skipped.
+			for (int32 Index = 0; Index < Healths.Num(); ++Index)
+			{
+				if (Healths[Index] < MaxHealths[Index] * 0.5f)
+				{
+					++StoreWounded;
+					StoreArmor += Armors[Index];
+				}
+			}
+		}
+		const double StoreSeconds = FPlatformTime::Seconds() - StoreStart;
+
+		UE_LOG(LogTemp, Display, TEXT("Attribute store benchmark, %d enemies, %d passes"), Count, Passes);
+		UE_LOG(LogTemp, Display, TEXT("  Attribute sets:  %.4f ms per pass (%d wounded, %.0f armor)"), AttributeSetSeconds * 1000.0 / Passes, AttributeSetWounded, AttributeSetArmor);
+		UE_LOG(LogTemp, Display, TEXT("  Attribute store: %.4f ms per pass (%d wounded, %.0f armor)"), StoreSeconds * 1000.0 / Passes, StoreWounded, StoreArmor);
+
+		for (UBaseAttributeSet* AttributeSet : AttributeSets)
+		{
+			AttributeSet->MarkAsGarbage();
+		}
+	}));
+
+#endif
+
+FTopDownAttributeHandle FTopDownAttributeStore::Allocate()
+{
+	int32 Index;
+	if (FreeSlots.Num() > 0)
+	{
+		Index = FreeSlots.Pop(EAllowShrinking::No);
+		AliveSlots[Index] = true;
+	}
+	else
+	{
+		Index = Generations.Add(1);
+		AliveSlots.Add(true);
+		for (TArray<float>& AttributeValues : Values)
+		{
+			AttributeValues.Add(0.f);
+		}
+	}
+
+	FTopDownAttributeHandle Handle;
+	Handle.Index = Index;
+	Handle.Generation = Generations[Index];
+	return Handle;
+}
+
+void FTopDownAttributeStore::Release(const FTopDownAttributeHandle& Handle)
+{
+	if (!IsValid(Handle)) return;
+
+	// Bumping the generation is what makes outstanding handles to this slot stale.
+	++Generations[Handle.Index];
+	AliveSlots[Handle.Index] = false;
+	FreeSlots.Add(Handle.Index);
+}
+
+void FTopDownAttributeStore::Reserve(int32 NumSlots)
+{
+	for (TArray<float>& AttributeValues : Values)
+	{
+		AttributeValues.Reserve(NumSlots);
+	}
+	Generations.Reserve(NumSlots);
+	AliveSlots.Reserve(NumSlots);
+}
+
+UTopDownAttributeStoreSubsystem* UTopDownAttributeStoreSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UTopDownAttributeStoreSubsystem>() : nullptr;
+}
+
+FGameplayAttribute UTopDownAttributeStoreSubsystem::GetGameplayAttribute(ETopDownStoredAttribute Attribute)
+{
+	switch (Attribute)
+	{
+	case ETopDownStoredAttribute::Health:					return UBaseAttributeSet::GetHealthAttribute();
+	case ETopDownStoredAttribute::MaxHealth:				return UBaseAttributeSet::GetMaxHealthAttribute();
+	case ETopDownStoredAttribute::Armor:					return UBaseAttributeSet::GetArmorAttribute();
+	case ETopDownStoredAttribute::MagicResistance:			return UBaseAttributeSet::GetMagicResistanceAttribute();
+	case ETopDownStoredAttribute::Evasion:					return UBaseAttributeSet::GetEvasionAttribute();
+	case ETopDownStoredAttribute::BlockChance:				return UBaseAttributeSet::GetBlockChanceAttribute();
+	case ETopDownStoredAttribute::CriticalHitResistance:	return UBaseAttributeSet::GetCriticalHitResistanceAttribute();
+	default:												return FGameplayAttribute();
+	}
+}
+
+FTopDownAttributeHandle UTopDownAttributeStoreSubsystem::Register(UAbilitySystemComponent* AbilitySystemComponent)
+{
+	if (!CVarAttributeStoreEnabled.GetValueOnGameThread() || !IsValid(AbilitySystemComponent)) return FTopDownAttributeHandle();
+
+	if (const FTopDownAttributeHandle* ExistingHandle = Handles.Find(AbilitySystemComponent))
+	{
+		return *ExistingHandle;
+	}
+
+	const FTopDownAttributeHandle Handle = Store.Allocate();
+	if (RegisteredAbilitySystems.Num() <= Handle.Index)
+	{
+		RegisteredAbilitySystems.SetNum(Handle.Index + 1);
+	}
+	FRegisteredAbilitySystem& Registered = RegisteredAbilitySystems[Handle.Index];
+	Registered.AbilitySystemComponent = AbilitySystemComponent;
+	Registered.AbilitySystemComponentKey = AbilitySystemComponent;
+
+	for (int32 AttributeIndex = 0; AttributeIndex < static_cast<int32>(ETopDownStoredAttribute::Num); ++AttributeIndex)
+	{
+		const ETopDownStoredAttribute StoredAttribute = static_cast<ETopDownStoredAttribute>(AttributeIndex);
+		const FGameplayAttribute Attribute = GetGameplayAttribute(StoredAttribute);
+
+		// Seed with the current value, then follow every change.
+		Store.SetValue(Handle, StoredAttribute, AbilitySystemComponent->GetNumericAttribute(Attribute));
+		Registered.ChangeDelegateHandles[AttributeIndex] = AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(Attribute).AddWeakLambda(this,
+			[this, Handle, StoredAttribute](const FOnAttributeChangeData& Data)
+			{
+				if (Store.IsValid(Handle))
+				{
+					Store.SetValue(Handle, StoredAttribute, Data.NewValue);
+				}
+			});
+	}
+
+	Handles.Add(AbilitySystemComponent, Handle);
+	SET_DWORD_STAT(STAT_AttributeStoreEntries, Store.GetNumAlive());
+	return Handle;
+}
+
+void UTopDownAttributeStoreSubsystem::Unregister(FTopDownAttributeHandle& Handle)
+{
+	if (Store.IsValid(Handle))
+	{
+		FRegisteredAbilitySystem& Registered = RegisteredAbilitySystems[Handle.Index];
+		UnbindAttributeChanges(Registered);
+		Handles.Remove(Registered.AbilitySystemComponentKey);
+		Registered = FRegisteredAbilitySystem();
+		Store.Release(Handle);
+		SET_DWORD_STAT(STAT_AttributeStoreEntries, Store.GetNumAlive());
+	}
+	Handle.Reset();
+}
+
+FTopDownAttributeHandle UTopDownAttributeStoreSubsystem::FindHandle(const UAbilitySystemComponent* AbilitySystemComponent) const
+{
+	const FTopDownAttributeHandle* Handle = Handles.Find(AbilitySystemComponent);
+	return Handle ? *Handle : FTopDownAttributeHandle();
+}
+
+void UTopDownAttributeStoreSubsystem::Deinitialize()
+{
+	for (FRegisteredAbilitySystem& Registered : RegisteredAbilitySystems)
+	{
+		UnbindAttributeChanges(Registered);
+	}
+	RegisteredAbilitySystems.Empty();
+	Handles.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTopDownAttributeStoreSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTopDownAttributeStoreSubsystem::UnbindAttributeChanges(FRegisteredAbilitySystem& Registered) const
+{
+	UAbilitySystemComponent* AbilitySystemComponent = Registered.AbilitySystemComponent.Get();
+	if (AbilitySystemComponent == nullptr) return;
+
+	for (int32 AttributeIndex = 0; AttributeIndex < static_cast<int32>(ETopDownStoredAttribute::Num); ++AttributeIndex)
+	{
+		AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(GetGameplayAttribute(static_cast<ETopDownStoredAttribute>(AttributeIndex)))
+			.Remove(Registered.ChangeDelegateHandles[AttributeIndex]);
+	}
+}
@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystem/TopDownCombatLogSubsystem.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Combat Log Events"), STAT_CombatLogEvents, STATGROUP_TopDown);
+
+static TAutoConsoleVariable<bool> CVarCombatLogEnabled(
+	TEXT("TopDown.CombatLog.Enabled"),
+	true,
+	TEXT("Record damage events into the combat log ring buffer."));
+
+static TAutoConsoleVariable<int32> CVarCombatLogCapacity(
+	TEXT("TopDown.CombatLog.Capacity"),
+	4096,
+	TEXT("Number of combat events kept per world, rounded up to a power of two. Read when the world starts."));
+
+static FAutoConsoleCommandWithWorldAndArgs CCombatLogFlush(
+	TEXT("TopDown.CombatLog.Flush"),
+	TEXT("Writes the buffered combat events to Saved/CombatLogs. Optionally takes a file name."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UTopDownCombatLogSubsystem* CombatLog = UTopDownCombatLogSubsystem::Get(World);
+		if (CombatLog == nullptr) return;
+
+		const FString FileName = Args.Num() > 0 ? Args[0] : FString::Printf(TEXT("CombatLog_%s.bin"), *FDateTime::Now().ToString());
+		const FString FilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("CombatLogs"), FileName);
+		if (CombatLog->FlushToFile(FilePath))
+		{
+			UE_LOG(LogTemp, Display, TEXT("Combat log written to %s"), *FilePath);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not write combat log to %s"), *FilePath);
+		}
+	}));
+
+namespace TopDownCombatLog
+{
+	// "TDCL"
+	static constexpr uint32 FileMagic = 0x4C434454;
+	static constexpr uint32 FileVersion = 2;
+
+	static void GetNameIds(const AActor* Actor, uint32& OutNameIndex, uint32& OutNameNumber)
+	{
+		if (Actor == nullptr) return;
+
+		const FName ActorName = Actor->GetFName();
+		OutNameIndex = ActorName.GetDisplayIndex().ToUnscrambledInt();
+		OutNameNumber = static_cast<uint32>(ActorName.GetNumber());
+	}
+
+	static uint64 MakeNameKey(const uint32 NameIndex, const uint32 NameNumber)
+	{
+		return (static_cast<uint64>(NameIndex) << 32) | NameNumber;
+	}
+}
+
+UTopDownCombatLogSubsystem* UTopDownCombatLogSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UTopDownCombatLogSubsystem>() : nullptr;
+}
+
+void UTopDownCombatLogSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const uint64 Capacity = FMath::RoundUpToPowerOfTwo64(FMath::Max(CVarCombatLogCapacity.GetValueOnGameThread(), 1));
+	Slots = MakeUnique<FCombatEventSlot[]>(Capacity);
+	SlotMask = Capacity - 1;
+	WriteIndex.store(0, std::memory_order_relaxed);
+}
+
+void UTopDownCombatLogSubsystem::Deinitialize()
+{
+	Slots.Reset();
+	SlotMask = 0;
+
+	Super::Deinitialize();
+}
+
+bool UTopDownCombatLogSubsystem::IsRecordingEnabled()
+{
+	return CVarCombatLogEnabled.GetValueOnAnyThread();
+}
+
+uint8 UTopDownCombatLogSubsystem::MakeDamageFlags(bool bEvaded, bool bBlocked, bool bCriticalHit, bool bFatal)
+{
+	return (bEvaded ? ETopDownCombatEventFlags::Evaded : 0) |
+		(bBlocked ? ETopDownCombatEventFlags::Blocked : 0) |
+		(bCriticalHit ? ETopDownCombatEventFlags::CriticalHit : 0) |
+		(bFatal ? ETopDownCombatEventFlags::Fatal : 0);
+}
+
+void UTopDownCombatLogSubsystem::RecordDamage(ETopDownCombatEventType Type, const AActor* SourceActor, const AActor* TargetActor,
+	float RawDamage, float MitigatedDamage, uint8 Flags)
+{
+	if (!Slots.IsValid() || !IsRecordingEnabled()) return;
+
+	INC_DWORD_STAT(STAT_CombatLogEvents);
+
+	// Claiming the slot is the only shared write, the rest only touches our own slot.
+	const uint64 EventIndex = WriteIndex.fetch_add(1, std::memory_order_relaxed);
+	FCombatEventSlot& Slot = Slots[EventIndex & SlotMask];
+
+	Slot.Sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	FTopDownCombatEvent& Event = Slot.Event;
+	FMemory::Memzero(&Event, sizeof(FTopDownCombatEvent));
+	Event.WorldTime = GetWorld()->GetTimeSeconds();
+	Event.Frame = GFrameCounter;
+	TopDownCombatLog::GetNameIds(SourceActor, Event.SourceNameIndex, Event.SourceNameNumber);
+	TopDownCombatLog::GetNameIds(TargetActor, Event.TargetNameIndex, Event.TargetNameNumber);
+	Event.RawDamage = RawDamage;
+	Event.MitigatedDamage = MitigatedDamage;
+	Event.Type = Type;
+	Event.Flags = Flags;
+
+	Slot.Sequence.store(EventIndex + 1, std::memory_order_release);
+}
+
+void UTopDownCombatLogSubsystem::GetEvents(TArray<FTopDownCombatEvent>& OutEvents) const
+{
+	OutEvents.Reset();
+	if (!Slots.IsValid()) return;
+
+	const uint64 Capacity = SlotMask + 1;
+	const uint64 EndIndex = WriteIndex.load(std::memory_order_acquire);
+	const uint64 StartIndex = EndIndex > Capacity ? EndIndex - Capacity : 0;
+	OutEvents.Reserve(EndIndex - StartIndex);
+
+	for (uint64 EventIndex = StartIndex; EventIndex < EndIndex; ++EventIndex)
+	{
+		const FCombatEventSlot& Slot = Slots[EventIndex & SlotMask];
+		if (Slot.Sequence.load(std::memory_order_acquire) != EventIndex + 1) continue;
+
+		// Copied bytewise so the zeroed padding comes along.
+		FTopDownCombatEvent Event;
+		FMemory::Memcpy(&Event, &Slot.Event, sizeof(FTopDownCombatEvent));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		// A writer lapped us while copying, the copy may be torn.
+		if (Slot.Sequence.load(std::memory_order_relaxed) != EventIndex + 1) continue;
+
+		FMemory::Memcpy(&OutEvents.AddUninitialized_GetRef(), &Event, sizeof(FTopDownCombatEvent));
+	}
+}
+
+bool UTopDownCombatLogSubsystem::FlushToFile(const FString& FilePath) const
+{
+	TArray<FTopDownCombatEvent> Events;
+	GetEvents(Events);
+
+	// Names were captured when the events were recorded, so this holds for actors destroyed since.
+	TMap<uint64, FString> ActorNames;
+	for (const FTopDownCombatEvent& Event : Events)
+	{
+		const TPair<uint32, uint32> NameIds[] = {
+			{ Event.SourceNameIndex, Event.SourceNameNumber },
+			{ Event.TargetNameIndex, Event.TargetNameNumber } };
+		for (const TPair<uint32, uint32>& NameId : NameIds)
+		{
+			const uint64 NameKey = TopDownCombatLog::MakeNameKey(NameId.Key, NameId.Value);
+			if (NameKey == 0 || ActorNames.Contains(NameKey)) continue;
+
+			const FName ActorName = FName::CreateFromDisplayId(FNameEntryId::FromUnscrambledInt(NameId.Key), static_cast<int32>(NameId.Value));
+			ActorNames.Add(NameKey, ActorName.ToString());
+		}
+	}
+
+	const TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!FileWriter.IsValid()) return false;
+
+	/*
+	 * Layout: magic, version, event size, event count, the raw FTopDownCombatEvent array,
+	 * then the name count followed by (name index << 32 | name number, name) pairs.
+	 */
+	uint32 Magic = TopDownCombatLog::FileMagic;
+	uint32 Version = TopDownCombatLog::FileVersion;
+	uint32 EventSize = sizeof(FTopDownCombatEvent);
+	int32 EventCount = Events.Num();
+	*FileWriter << Magic << Version << EventSize << EventCount;
+	FileWriter->Serialize(Events.GetData(), Events.Num() * sizeof(FTopDownCombatEvent));
+
+	int32 NameCount = ActorNames.Num();
+	*FileWriter << NameCount;
+	for (TPair<uint64, FString>& ActorName : ActorNames)
+	{
+		*FileWriter << ActorName.Key << ActorName.Value;
+	}
+	return FileWriter->Close();
+}
+
+bool UTopDownCombatLogSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,431 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystem/TopDownCombatSimulationSubsystem.h"
+
+#include "AbilitySystemComponent.h"
+#include "GameplayEffect.h"
+#include "Abilities/GameplayAbility.h"
+#include "AbilitySystem/BaseAttributeSet.h"
+#include "AbilitySystem/Abilities/TopDownProjectileAbility.h"
+#include "Actor/BaseEffectActor.h"
+#include "Character/EnemyCharacter.h"
+#include "Character/PlayerCharacter.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+bool FTopDownCombatSimulationTimer::bSimulationActive = false;
+uint64 FTopDownCombatSimulationTimer::ExecCalcCycles = 0;
+uint32 FTopDownCombatSimulationTimer::ExecCalcCount = 0;
+uint32 FTopDownCombatSimulationCounters::EffectExecutions = 0;
+uint32 FTopDownCombatSimulationCounters::ContextResolves = 0;
+uint32 FTopDownCombatSimulationCounters::ContextAllocationsAvoided = 0;
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithWorldAndArgs CCombatSimulationRun(
+	TEXT("TopDown.CombatSim.Run"),
+	TEXT("Runs the headless combat benchmark in the current world and writes a CSV to Saved/CombatSimulation.\n")
+	TEXT("Enemies=<n> Players=<n> Ticks=<n> CastInterval=<n> EffectActors=<n> EffectInterval=<n> Spacing=<cm> RegenPeriod=<s>\n")
+	TEXT("EnemyClass=<path> PlayerClass=<path> EffectActorClass=<path> AbilityClass=<path> Out=<file> Quit"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UTopDownCombatSimulationSubsystem* CombatSimulation = World ? World->GetSubsystem<UTopDownCombatSimulationSubsystem>() : nullptr;
+		if (CombatSimulation == nullptr) return;
+
+		const FString Cmd = FString::Join(Args, TEXT(" "));
+		FTopDownCombatSimulationSettings Settings;
+		FParse::Value(*Cmd, TEXT("Enemies="), Settings.EnemyCount);
+		FParse::Value(*Cmd, TEXT("Players="), Settings.PlayerCount);
+		FParse::Value(*Cmd, TEXT("Ticks="), Settings.TickCount);
+		FParse::Value(*Cmd, TEXT("CastInterval="), Settings.CastInterval);
+		FParse::Value(*Cmd, TEXT("EffectActors="), Settings.EffectActorCount);
+		FParse::Value(*Cmd, TEXT("EffectInterval="), Settings.EffectActorInterval);
+		FParse::Value(*Cmd, TEXT("Spacing="), Settings.Spacing);
+		FParse::Value(*Cmd, TEXT("RegenPeriod="), Settings.RegenPeriod);
+		Settings.bQuitWhenDone = Args.Contains(TEXT("Quit"));
+
+		FString ClassPath = TEXT("/Game/Blueprints/Characters/Enemy/Goblin_Spear/BP_Goblin_Spear.BP_Goblin_Spear_C");
+		FParse::Value(*Cmd, TEXT("EnemyClass="), ClassPath);
+		Settings.EnemyClass = FSoftClassPath(ClassPath);
+
+		ClassPath = TEXT("/Game/Blueprints/Characters/Player/BP_PlayerCharacter.BP_PlayerCharacter_C");
+		FParse::Value(*Cmd, TEXT("PlayerClass="), ClassPath);
+		Settings.PlayerClass = FSoftClassPath(ClassPath);
+
+		ClassPath = TEXT("/Game/Blueprints/Actors/Areas/BP_FireAreaEffect.BP_FireAreaEffect_C");
+		FParse::Value(*Cmd, TEXT("EffectActorClass="), ClassPath);
+		Settings.EffectActorClass = FSoftClassPath(ClassPath);
+
+		ClassPath = TEXT("/Game/Blueprints/AbilitySystem/GameplayAbilities/Fire/FireBolt/GA_FireBolt.GA_FireBolt_C");
+		FParse::Value(*Cmd, TEXT("AbilityClass="), ClassPath);
+		Settings.ProjectileAbilityClass = FSoftClassPath(ClassPath);
+
+		Settings.OutputFileName = FString::Printf(TEXT("CombatSimulation_%s.csv"), *FDateTime::Now().ToString());
+		FParse::Value(*Cmd, TEXT("Out="), Settings.OutputFileName);
+
+		if (!CombatSimulation->StartSimulation(Settings) && Settings.bQuitWhenDone)
+		{
+			FPlatformMisc::RequestExitWithStatus(false, 1);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CCombatSimulationStop(
+	TEXT("TopDown.CombatSim.Stop"),
+	TEXT("Stops the running combat benchmark without writing a report."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UTopDownCombatSimulationSubsystem* CombatSimulation = World ? World->GetSubsystem<UTopDownCombatSimulationSubsystem>() : nullptr)
+		{
+			CombatSimulation->StopSimulation();
+		}
+	}));
+
+#endif
+
+bool UTopDownCombatSimulationSubsystem::StartSimulation(const FTopDownCombatSimulationSettings& InSettings)
+{
+	if (bRunning) return false;
+
+	UWorld* World = GetWorld();
+	if (World->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Combat simulation has to run on the server."));
+		return false;
+	}
+
+	UClass* EnemyClass = InSettings.EnemyClass.TryLoadClass<AEnemyCharacter>();
+	UClass* PlayerClass = InSettings.PlayerClass.TryLoadClass<APlayerCharacter>();
+	UClass* EffectActorClass = InSettings.EffectActorClass.TryLoadClass<ABaseEffectActor>();
+	if (EnemyClass == nullptr || PlayerClass == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Combat simulation could not load %s or %s."), *InSettings.EnemyClass.ToString(), *InSettings.PlayerClass.ToString());
+		return false;
+	}
+
+	Settings = InSettings;
+	Settings.TickCount = FMath::Max(Settings.TickCount, 1);
+	Settings.CastInterval = FMath::Max(Settings.CastInterval, 1);
+	Settings.EffectActorInterval = FMath::Max(Settings.EffectActorInterval, 1);
+
+	SpawnCombatants(EnemyClass, PlayerClass, EffectActorClass);
+	if (Settings.RegenPeriod > 0.f)
+	{
+		ApplyRegen();
+	}
+
+	Samples.Reset();
+	Samples.Reserve(Settings.TickCount);
+	CurrentTick = 0;
+	NextTargetIndex = 0;
+	LastTickTime = FPlatformTime::Seconds();
+	bRunning = true;
+	FTopDownCombatSimulationTimer::ExecCalcCycles = 0;
+	FTopDownCombatSimulationTimer::ExecCalcCount = 0;
+	FTopDownCombatSimulationTimer::bSimulationActive = true;
+	FTopDownCombatSimulationCounters::EffectExecutions = 0;
+	FTopDownCombatSimulationCounters::ContextResolves = 0;
+	FTopDownCombatSimulationCounters::ContextAllocationsAvoided = 0;
+
+	UE_LOG(LogTemp, Display, TEXT("Combat simulation started: %d enemies, %d players, %d ticks."), Enemies.Num(), Players.Num(), Settings.TickCount);
+	return true;
+}
+
+void UTopDownCombatSimulationSubsystem::StopSimulation()
+{
+	if (!bRunning) return;
+
+	bRunning = false;
+	FTopDownCombatSimulationTimer::bSimulationActive = false;
+	DestroyCombatants();
+}
+
+void UTopDownCombatSimulationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bRunning) return;
+
+	// Counters cover everything that ran since the previous simulated frame, then start over.
+	RecordSample();
+	FTopDownCombatSimulationTimer::ExecCalcCycles = 0;
+	FTopDownCombatSimulationTimer::ExecCalcCount = 0;
+	FTopDownCombatSimulationCounters::EffectExecutions = 0;
+	FTopDownCombatSimulationCounters::ContextResolves = 0;
+	FTopDownCombatSimulationCounters::ContextAllocationsAvoided = 0;
+
+	if (++CurrentTick >= Settings.TickCount)
+	{
+		WriteReport();
+		StopSimulation();
+		if (Settings.bQuitWhenDone)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+		return;
+	}
+
+	CastsThisTick = 0;
+	if (CurrentTick % Settings.CastInterval == 0)
+	{
+		CastProjectiles();
+	}
+	if (CurrentTick % Settings.EffectActorInterval == 0)
+	{
+		MoveEffectActors();
+	}
+}
+
+TStatId UTopDownCombatSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownCombatSimulationSubsystem, STATGROUP_Tickables);
+}
+
+bool UTopDownCombatSimulationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return !UE_BUILD_SHIPPING && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UTopDownCombatSimulationSubsystem::Deinitialize()
+{
+	// The world is going away, its actors with it. Only stop the exec calc timing.
+	if (bRunning)
+	{
+		bRunning = false;
+		FTopDownCombatSimulationTimer::bSimulationActive = false;
+	}
+
+	Super::Deinitialize();
+}
+
+bool UTopDownCombatSimulationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTopDownCombatSimulationSubsystem::SpawnCombatants(UClass* EnemyClass, UClass* PlayerClass, UClass* EffectActorClass)
+{
+	UWorld* World = GetWorld();
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	// Enemies on a square grid in front of the players, so every projectile has something to hit.
+	const int32 EnemyColumns = FMath::Max(FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(Settings.EnemyCount))), 1);
+	for (int32 Index = 0; Index < Settings.EnemyCount; ++Index)
+	{
+		const FVector Location((Index / EnemyColumns + 2) * Settings.Spacing, (Index % EnemyColumns - EnemyColumns / 2) * Settings.Spacing, 100.f);
+		if (AEnemyCharacter* Enemy = World->SpawnActor<AEnemyCharacter>(EnemyClass, Location, FRotator(0.f, 180.f, 0.f), SpawnParameters))
+		{
+			Enemies.Add(Enemy);
+		}
+	}
+
+	// Players need a controller with a player state, that is where their ability system component lives.
+	for (int32 Index = 0; Index < Settings.PlayerCount; ++Index)
+	{
+		const FVector Location(0.f, (Index - Settings.PlayerCount / 2) * Settings.Spacing, 100.f);
+		APlayerCharacter* Player = World->SpawnActor<APlayerCharacter>(PlayerClass, Location, FRotator::ZeroRotator, SpawnParameters);
+		if (Player == nullptr) continue;
+
+		APlayerController* PlayerController = World->SpawnActor<APlayerController>(SpawnParameters);
+		PlayerController->Possess(Player);
+		PlayerControllers.Add(PlayerController);
+		Players.Add(Player);
+
+		UAbilitySystemComponent* AbilitySystemComponent = Player->GetAbilitySystemComponent();
+		if (AbilitySystemComponent && FindProjectileAbility(Player) == nullptr)
+		{
+			if (UClass* ProjectileAbilityClass = Settings.ProjectileAbilityClass.TryLoadClass<UTopDownProjectileAbility>())
+			{
+				AbilitySystemComponent->GiveAbility(FGameplayAbilitySpec(ProjectileAbilityClass, 1));
+			}
+		}
+	}
+
+	if (EffectActorClass && !Enemies.IsEmpty())
+	{
+		for (int32 Index = 0; Index < Settings.EffectActorCount; ++Index)
+		{
+			if (ABaseEffectActor* EffectActor = World->SpawnActor<ABaseEffectActor>(EffectActorClass, Enemies[Index % Enemies.Num()]->GetActorLocation(), FRotator::ZeroRotator, SpawnParameters))
+			{
+				EffectActors.Add(EffectActor);
+			}
+		}
+	}
+}
+
+void UTopDownCombatSimulationSubsystem::ApplyRegen()
+{
+	if (RegenEffect == nullptr)
+	{
+		RegenEffect = NewObject<UGameplayEffect>(this, FName(TEXT("GE_CombatSimulationRegen")));
+		RegenEffect->DurationPolicy = EGameplayEffectDurationType::Infinite;
+
+		for (const FGameplayAttribute& Attribute : { UBaseAttributeSet::GetHealthAttribute(), UBaseAttributeSet::GetManaAttribute(), UBaseAttributeSet::GetStaminaAttribute() })
+		{
+			FGameplayModifierInfo& ModifierInfo = RegenEffect->Modifiers.AddDefaulted_GetRef();
+			ModifierInfo.Attribute = Attribute;
+			ModifierInfo.ModifierOp = EGameplayModOp::Additive;
+			ModifierInfo.ModifierMagnitude = FGameplayEffectModifierMagnitude(FScalableFloat(1.f));
+		}
+	}
+	// Read when the spec is made, so a later run can use another period.
+	RegenEffect->Period = FScalableFloat(Settings.RegenPeriod);
+
+	auto ApplyRegenTo = [this](UAbilitySystemComponent* AbilitySystemComponent)
+	{
+		if (AbilitySystemComponent)
+		{
+			AbilitySystemComponent->ApplyGameplayEffectToSelf(RegenEffect, 1.f, AbilitySystemComponent->MakeEffectContext());
+		}
+	};
+	for (const AEnemyCharacter* Enemy : Enemies)
+	{
+		ApplyRegenTo(Enemy->GetAbilitySystemComponent());
+	}
+	for (const APlayerCharacter* Player : Players)
+	{
+		ApplyRegenTo(Player->GetAbilitySystemComponent());
+	}
+}
+
+void UTopDownCombatSimulationSubsystem::CastProjectiles()
+{
+	if (Enemies.IsEmpty()) return;
+
+	for (const APlayerCharacter* Player : Players)
+	{
+		UTopDownProjectileAbility* ProjectileAbility = FindProjectileAbility(Player);
+		if (ProjectileAbility == nullptr) continue;
+
+		// Spread the shots over the grid instead of focusing one enemy to death in the first second.
+		const AEnemyCharacter* Target = Enemies[NextTargetIndex++ % Enemies.Num()];
+		if (!IsValid(Target)) continue;
+
+		ProjectileAbility->SpawnProjectileAtLocation(Target->GetActorLocation());
+		++CastsThisTick;
+	}
+}
+
+void UTopDownCombatSimulationSubsystem::MoveEffectActors()
+{
+	if (Enemies.IsEmpty()) return;
+
+	// Teleporting updates overlaps, which ends the overlap with the previous enemy and starts one with the next.
+	for (int32 Index = 0; Index < EffectActors.Num(); ++Index)
+	{
+		const AEnemyCharacter* Target = Enemies[(CurrentTick / Settings.EffectActorInterval + Index) % Enemies.Num()];
+		if (IsValid(EffectActors[Index]) && IsValid(Target))
+		{
+			EffectActors[Index]->SetActorLocation(Target->GetActorLocation(), false, nullptr, ETeleportType::TeleportPhysics);
+		}
+	}
+}
+
+void UTopDownCombatSimulationSubsystem::RecordSample()
+{
+	const double Now = FPlatformTime::Seconds();
+
+	FTopDownCombatSimulationSample& Sample = Samples.AddDefaulted_GetRef();
+	Sample.Tick = CurrentTick;
+	Sample.FrameTimeMs = (Now - LastTickTime) * 1000.0;
+	Sample.GameThreadTimeMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Sample.ExecCalcTimeMs = FPlatformTime::ToMilliseconds64(FTopDownCombatSimulationTimer::ExecCalcCycles);
+	Sample.ExecCalcCount = FTopDownCombatSimulationTimer::ExecCalcCount;
+	Sample.Casts = CastsThisTick;
+	Sample.EffectExecutions = FTopDownCombatSimulationCounters::EffectExecutions;
+	Sample.ContextResolves = FTopDownCombatSimulationCounters::ContextResolves;
+	Sample.ContextAllocationsAvoided = FTopDownCombatSimulationCounters::ContextAllocationsAvoided;
+	Sample.UsedPhysicalMemory = FPlatformMemory::GetStats().UsedPhysical;
+	if (const UNetDriver* NetDriver = GetWorld()->GetNetDriver())
+	{
+		Sample.NetOutBytes = NetDriver->OutTotalBytes;
+	}
+
+	LastTickTime = Now;
+}
+
+void UTopDownCombatSimulationSubsystem::WriteReport() const
+{
+	FString Csv;
+	Csv.Reserve((Samples.Num() + 1) * 64);
+	Csv += TEXT("Tick,FrameTimeMs,GameThreadTimeMs,ExecCalcTimeMs,ExecCalcCount,Casts,EffectExecutions,ContextResolves,ContextAllocationsAvoided,UsedPhysicalMB,NetOutBytes\n");
+
+	double TotalFrameTimeMs = 0.0;
+	double TotalExecCalcTimeMs = 0.0;
+	uint64 TotalEffectExecutions = 0;
+	uint64 TotalContextAllocationsAvoided = 0;
+	for (int32 Index = 0; Index < Samples.Num(); ++Index)
+	{
+		const FTopDownCombatSimulationSample& Sample = Samples[Index];
+		// Net bytes are a running total, the report shows what each frame added.
+		const uint64 NetOutBytes = Index > 0 ? Sample.NetOutBytes - Samples[Index - 1].NetOutBytes : 0;
+		Csv.Appendf(TEXT("%d,%.3f,%.3f,%.4f,%u,%d,%u,%u,%u,%.1f,%llu\n"), Sample.Tick, Sample.FrameTimeMs, Sample.GameThreadTimeMs,
+			Sample.ExecCalcTimeMs, Sample.ExecCalcCount, Sample.Casts, Sample.EffectExecutions, Sample.ContextResolves, Sample.ContextAllocationsAvoided,
+			Sample.UsedPhysicalMemory / (1024.0 * 1024.0), NetOutBytes);
+
+		TotalFrameTimeMs += Sample.FrameTimeMs;
+		TotalExecCalcTimeMs += Sample.ExecCalcTimeMs;
+		TotalEffectExecutions += Sample.EffectExecutions;
+		TotalContextAllocationsAvoided += Sample.ContextAllocationsAvoided;
+	}
+
+	const FString FilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("CombatSimulation"), Settings.OutputFileName);
+	if (FFileHelper::SaveStringToFile(Csv, *FilePath))
+	{
+		const int32 SampleCount = FMath::Max(Samples.Num(), 1);
+		// Rates are per second of wall clock time spent in the recorded frames.
+		const double TotalSeconds = FMath::Max(TotalFrameTimeMs / 1000.0, UE_SMALL_NUMBER);
+		UE_LOG(LogTemp, Display, TEXT("Combat simulation written to %s. Average frame %.3f ms, exec calc %.4f ms, %.0f effect executions/s, %.0f context allocations avoided/s."),
+			*FilePath, TotalFrameTimeMs / SampleCount, TotalExecCalcTimeMs / SampleCount, TotalEffectExecutions / TotalSeconds, TotalContextAllocationsAvoided / TotalSeconds);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write combat simulation report to %s"), *FilePath);
+	}
+}
+
+void UTopDownCombatSimulationSubsystem::DestroyCombatants()
+{
+	for (ABaseEffectActor* EffectActor : EffectActors)
+	{
+		if (IsValid(EffectActor)) EffectActor->Destroy();
+	}
+	for (AController* PlayerController : PlayerControllers)
+	{
+		if (IsValid(PlayerController)) PlayerController->Destroy();
+	}
+	for (APlayerCharacter* Player : Players)
+	{
+		if (IsValid(Player)) Player->Destroy();
+	}
+	for (AEnemyCharacter* Enemy : Enemies)
+	{
+		if (IsValid(Enemy)) Enemy->Destroy();
+	}
+
+	EffectActors.Reset();
+	PlayerControllers.Reset();
+	Players.Reset();
+	Enemies.Reset();
+}
+
+UTopDownProjectileAbility* UTopDownCombatSimulationSubsystem::FindProjectileAbility(const APlayerCharacter* PlayerCharacter) const
+{
+	const UAbilitySystemComponent* AbilitySystemComponent = IsValid(PlayerCharacter) ? PlayerCharacter->GetAbilitySystemComponent() : nullptr;
+	if (AbilitySystemComponent == nullptr) return nullptr;
+
+	// Casting goes straight to SpawnProjectile, which needs the instance that holds the actor info, not the CDO.
+	for (const FGameplayAbilitySpec& AbilitySpec : AbilitySystemComponent->GetActivatableAbilities())
+	{
+		if (UTopDownProjectileAbility* ProjectileAbility = Cast<UTopDownProjectileAbility>(AbilitySpec.GetPrimaryInstance()))
+		{
+			return ProjectileAbility;
+		}
+	}
+	return nullptr;
+}
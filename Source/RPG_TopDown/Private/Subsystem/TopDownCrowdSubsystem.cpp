@@ -0,0 +1,384 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystem/TopDownCrowdSubsystem.h"
+
+#include "AbilitySystemComponent.h"
+#include "MassEntityManager.h"
+#include "MassEntityQuery.h"
+#include "MassEntitySubsystem.h"
+#include "MassExecutionContext.h"
+#include "Character/EnemyCharacter.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd LOD Update"), STAT_CrowdLODUpdate, STATGROUP_TopDown);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Entities"), STAT_CrowdEntities, STATGROUP_TopDown);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Actors"), STAT_CrowdActors, STATGROUP_TopDown);
+
+static TAutoConsoleVariable<bool> CVarCrowdEnabled(
+	TEXT("TopDown.Crowd.Enabled"),
+	false,
+	TEXT("Demote enemies far from every player to lightweight crowd entities. Off by default, enemies also need bCanDemoteToCrowd.\n")
+	TEXT("Already demoted enemies are still promoted while off."));
+
+static TAutoConsoleVariable<float> CVarCrowdDemoteDistance(
+	TEXT("TopDown.Crowd.DemoteDistance"),
+	8000.f,
+	TEXT("Enemies further than this (cm) from every player are demoted to crowd entities."));
+
+static TAutoConsoleVariable<float> CVarCrowdPromoteDistance(
+	TEXT("TopDown.Crowd.PromoteDistance"),
+	6000.f,
+	TEXT("Crowd entities within this (cm) of any player are spawned back as enemy actors. Keep it below the demote distance."));
+
+static TAutoConsoleVariable<float> CVarCrowdUpdateInterval(
+	TEXT("TopDown.Crowd.UpdateInterval"),
+	0.5f,
+	TEXT("Seconds between crowd LOD updates."));
+
+void UTopDownCrowdSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	UMassEntitySubsystem* MassEntitySubsystem = Collection.InitializeDependency<UMassEntitySubsystem>();
+	if (MassEntitySubsystem == nullptr) return;
+
+	EntityManager = MassEntitySubsystem->GetMutableEntityManager().AsShared();
+
+	const TArray<const UScriptStruct*> CrowdFragments = {
+		FTopDownCrowdLocationFragment::StaticStruct(),
+		FTopDownCrowdClassFragment::StaticStruct(),
+		FTopDownCrowdAbilityFragment::StaticStruct(),
+		FTopDownCrowdVisualFragment::StaticStruct()
+	};
+	CrowdArchetype = EntityManager->CreateArchetype(CrowdFragments);
+}
+
+void UTopDownCrowdSubsystem::Deinitialize()
+{
+	if (VisualHost)
+	{
+		VisualHost->Destroy();
+		VisualHost = nullptr;
+	}
+	VisualBatches.Empty();
+	ActiveEnemies.Empty();
+	AbilitySnapshots.Empty();
+	EntityManager.Reset();
+
+	Super::Deinitialize();
+}
+
+void UTopDownCrowdSubsystem::Tick(float DeltaTime)
+{
+	// Enemies are spawned and destroyed by the server, clients just see the replicated actors come and go.
+	if (!EntityManager.IsValid() || GetWorld()->GetNetMode() == NM_Client) return;
+
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate > 0.f) return;
+	TimeUntilUpdate = CVarCrowdUpdateInterval.GetValueOnGameThread();
+
+	UpdateCrowdLOD();
+}
+
+TStatId UTopDownCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownCrowdSubsystem, STATGROUP_Tickables);
+}
+
+void UTopDownCrowdSubsystem::RegisterEnemy(AEnemyCharacter* Enemy)
+{
+	if (IsValid(Enemy))
+	{
+		ActiveEnemies.AddUnique(Enemy);
+	}
+}
+
+void UTopDownCrowdSubsystem::UnregisterEnemy(AEnemyCharacter* Enemy)
+{
+	ActiveEnemies.RemoveSwap(Enemy, EAllowShrinking::No);
+}
+
+void UTopDownCrowdSubsystem::AddCrowdEnemy(TSubclassOf<AEnemyCharacter> EnemyClass, const FTransform& Transform, ECharacterClass CharacterClass, int32 Level)
+{
+	if (!EntityManager.IsValid() || EnemyClass == nullptr) return;
+
+	const FMassEntityHandle Entity = CreateCrowdEntity(EnemyClass, Transform, CharacterClass, Level, INDEX_NONE);
+	AddInstance(Entity, EnemyClass->GetDefaultObject<AEnemyCharacter>()->GetCrowdProxyMesh(), Transform);
+}
+
+bool UTopDownCrowdSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTopDownCrowdSubsystem::UpdateCrowdLOD()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CrowdLODUpdate);
+
+	GatherPlayerLocations();
+	// No players yet, or all of them are dead. Leave everything as it is rather than demoting the whole map.
+	if (PlayerLocations.IsEmpty()) return;
+
+	// Promote first, the same enemy can't be demoted again in this update since it is only registered once its actor begins play.
+	const float PromoteDistance = CVarCrowdPromoteDistance.GetValueOnGameThread();
+	TArray<FMassEntityHandle> EntitiesToPromote;
+	FMassEntityQuery PromotionQuery(EntityManager.ToSharedRef());
+	PromotionQuery.AddRequirement<FTopDownCrowdLocationFragment>(EMassFragmentAccess::ReadOnly);
+	FMassExecutionContext ExecutionContext(*EntityManager);
+	PromotionQuery.ForEachEntityChunk(*EntityManager, ExecutionContext, [this, PromoteDistance, &EntitiesToPromote](FMassExecutionContext& Context)
+	{
+		const TConstArrayView<FTopDownCrowdLocationFragment> Locations = Context.GetFragmentView<FTopDownCrowdLocationFragment>();
+		for (int32 EntityIndex = 0; EntityIndex < Context.GetNumEntities(); ++EntityIndex)
+		{
+			if (IsNearAnyPlayer(Locations[EntityIndex].Transform.GetLocation(), PromoteDistance))
+			{
+				EntitiesToPromote.Add(Context.GetEntity(EntityIndex));
+			}
+		}
+	});
+	for (const FMassEntityHandle& Entity : EntitiesToPromote)
+	{
+		PromoteEntity(Entity);
+	}
+
+	if (CVarCrowdEnabled.GetValueOnGameThread())
+	{
+		const float DemoteDistance = CVarCrowdDemoteDistance.GetValueOnGameThread();
+		for (int32 EnemyIndex = ActiveEnemies.Num() - 1; EnemyIndex >= 0; --EnemyIndex)
+		{
+			AEnemyCharacter* Enemy = ActiveEnemies[EnemyIndex].Get();
+			if (Enemy == nullptr)
+			{
+				ActiveEnemies.RemoveAtSwap(EnemyIndex, 1, EAllowShrinking::No);
+				continue;
+			}
+			if (Enemy->bHitReacting || IsNearAnyPlayer(Enemy->GetActorLocation(), DemoteDistance)) continue;
+
+			ActiveEnemies.RemoveAtSwap(EnemyIndex, 1, EAllowShrinking::No);
+			DemoteEnemy(Enemy);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_CrowdEntities, NumCrowdEntities);
+	SET_DWORD_STAT(STAT_CrowdActors, ActiveEnemies.Num());
+}
+
+void UTopDownCrowdSubsystem::GatherPlayerLocations()
+{
+	PlayerLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APawn* Pawn = It->Get() ? It->Get()->GetPawn() : nullptr)
+		{
+			PlayerLocations.Add(Pawn->GetActorLocation());
+		}
+	}
+}
+
+bool UTopDownCrowdSubsystem::IsNearAnyPlayer(const FVector& Location, float Distance) const
+{
+	const float DistanceSquared = FMath::Square(Distance);
+	for (const FVector& PlayerLocation : PlayerLocations)
+	{
+		if (FVector::DistSquared2D(Location, PlayerLocation) < DistanceSquared)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UTopDownCrowdSubsystem::DemoteEnemy(AEnemyCharacter* Enemy)
+{
+	const int32 SnapshotId = SnapshotAbilitySystem(Enemy->GetAbilitySystemComponent());
+
+	const FTransform Transform = Enemy->GetActorTransform();
+	const FMassEntityHandle Entity = CreateCrowdEntity(Enemy->GetClass(), Transform, Enemy->GetCharacterClass(), Enemy->GetCharacterLevel(), SnapshotId);
+	AddInstance(Entity, Enemy->GetCrowdProxyMesh(), Transform);
+
+	// EndPlay unregisters it from the spatial grid, attribute store and health bars.
+	Enemy->Destroy();
+}
+
+void UTopDownCrowdSubsystem::PromoteEntity(const FMassEntityHandle& Entity)
+{
+	const FTopDownCrowdLocationFragment Location = EntityManager->GetFragmentDataChecked<FTopDownCrowdLocationFragment>(Entity);
+	const FTopDownCrowdClassFragment Class = EntityManager->GetFragmentDataChecked<FTopDownCrowdClassFragment>(Entity);
+	const int32 SnapshotId = EntityManager->GetFragmentDataChecked<FTopDownCrowdAbilityFragment>(Entity).SnapshotId;
+	RemoveInstance(EntityManager->GetFragmentDataChecked<FTopDownCrowdVisualFragment>(Entity));
+	EntityManager->DestroyEntity(Entity);
+	--NumCrowdEntities;
+
+	AEnemyCharacter* Enemy = Class.EnemyClass ? GetWorld()->SpawnActorDeferred<AEnemyCharacter>(Class.EnemyClass, Location.Transform, nullptr, nullptr,
+		ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn) : nullptr;
+	if (Enemy)
+	{
+		// Level and class have to be in place before BeginPlay applies the default attributes.
+		Enemy->InitializeSpawnDefaults(Class.Level, Class.CharacterClass);
+		Enemy->FinishSpawning(Location.Transform);
+		RestoreAbilitySystem(Enemy->GetAbilitySystemComponent(), SnapshotId);
+	}
+
+	AbilitySnapshots.Remove(SnapshotId);
+}
+
+FMassEntityHandle UTopDownCrowdSubsystem::CreateCrowdEntity(TSubclassOf<AEnemyCharacter> EnemyClass, const FTransform& Transform, ECharacterClass CharacterClass, int32 Level, int32 SnapshotId)
+{
+	const FMassEntityHandle Entity = EntityManager->CreateEntity(CrowdArchetype);
+	EntityManager->GetFragmentDataChecked<FTopDownCrowdLocationFragment>(Entity).Transform = Transform;
+
+	FTopDownCrowdClassFragment& Class = EntityManager->GetFragmentDataChecked<FTopDownCrowdClassFragment>(Entity);
+	Class.EnemyClass = EnemyClass;
+	Class.CharacterClass = CharacterClass;
+	Class.Level = Level;
+
+	EntityManager->GetFragmentDataChecked<FTopDownCrowdAbilityFragment>(Entity).SnapshotId = SnapshotId;
+
+	++NumCrowdEntities;
+	return Entity;
+}
+
+int32 UTopDownCrowdSubsystem::SnapshotAbilitySystem(const UAbilitySystemComponent* AbilitySystemComponent)
+{
+	if (AbilitySystemComponent == nullptr) return INDEX_NONE;
+
+	FTopDownCrowdAbilitySnapshot Snapshot;
+	for (const UAttributeSet* AttributeSet : AbilitySystemComponent->GetSpawnedAttributes())
+	{
+		if (AttributeSet == nullptr) continue;
+
+		TArray<FGameplayAttribute> Attributes;
+		UAttributeSet::GetAttributesFromSetClass(AttributeSet->GetClass(), Attributes);
+		for (const FGameplayAttribute& Attribute : Attributes)
+		{
+			FTopDownCrowdAttributeSnapshot& AttributeSnapshot = Snapshot.AttributeBaseValues.AddDefaulted_GetRef();
+			AttributeSnapshot.Attribute = Attribute;
+			AttributeSnapshot.BaseValue = AbilitySystemComponent->GetNumericAttributeBase(Attribute);
+		}
+	}
+
+	// Instant effects are already in the base values, only duration and infinite effects are still active.
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	for (const FActiveGameplayEffectHandle& EffectHandle : AbilitySystemComponent->GetActiveEffects(FGameplayEffectQuery()))
+	{
+		const FActiveGameplayEffect* ActiveEffect = AbilitySystemComponent->GetActiveGameplayEffect(EffectHandle);
+		if (ActiveEffect == nullptr || ActiveEffect->IsPendingRemove || ActiveEffect->Spec.Def == nullptr) continue;
+
+		FTopDownCrowdEffectSnapshot& EffectSnapshot = Snapshot.ActiveEffects.AddDefaulted_GetRef();
+		EffectSnapshot.EffectClass = ActiveEffect->Spec.Def->GetClass();
+		EffectSnapshot.SetByCallerMagnitudes = ActiveEffect->Spec.SetByCallerTagMagnitudes;
+		EffectSnapshot.Level = ActiveEffect->Spec.GetLevel();
+		EffectSnapshot.StackCount = ActiveEffect->Spec.GetStackCount();
+		EffectSnapshot.TimeRemaining = ActiveEffect->GetDuration() == FGameplayEffectConstants::INFINITE_DURATION
+			? FGameplayEffectConstants::INFINITE_DURATION
+			: ActiveEffect->GetTimeRemaining(WorldTime);
+	}
+
+	const int32 SnapshotId = NextSnapshotId++;
+	AbilitySnapshots.Add(SnapshotId, MoveTemp(Snapshot));
+	return SnapshotId;
+}
+
+void UTopDownCrowdSubsystem::RestoreAbilitySystem(UAbilitySystemComponent* AbilitySystemComponent, int32 SnapshotId) const
+{
+	const FTopDownCrowdAbilitySnapshot* Snapshot = AbilitySnapshots.Find(SnapshotId);
+	if (AbilitySystemComponent == nullptr || Snapshot == nullptr) return;
+
+	const auto RestoreBaseValues = [AbilitySystemComponent, Snapshot]()
+	{
+		for (const FTopDownCrowdAttributeSnapshot& AttributeSnapshot : Snapshot->AttributeBaseValues)
+		{
+			AbilitySystemComponent->SetNumericAttributeBase(AttributeSnapshot.Attribute, AttributeSnapshot.BaseValue);
+		}
+	};
+
+	// BeginPlay already applied the default attribute effects, they are not applied a second time.
+	TSet<const UClass*> DefaultEffectClasses;
+	for (const FActiveGameplayEffectHandle& EffectHandle : AbilitySystemComponent->GetActiveEffects(FGameplayEffectQuery()))
+	{
+		if (const FActiveGameplayEffect* ActiveEffect = AbilitySystemComponent->GetActiveGameplayEffect(EffectHandle))
+		{
+			DefaultEffectClasses.Add(ActiveEffect->Spec.Def ? ActiveEffect->Spec.Def->GetClass() : nullptr);
+		}
+	}
+
+	RestoreBaseValues();
+	for (const FTopDownCrowdEffectSnapshot& EffectSnapshot : Snapshot->ActiveEffects)
+	{
+		if (EffectSnapshot.EffectClass == nullptr || DefaultEffectClasses.Contains(EffectSnapshot.EffectClass) || EffectSnapshot.TimeRemaining == 0.f) continue;
+
+		// The original instigator may be long gone, the restored effect comes from the enemy itself.
+		const FGameplayEffectSpecHandle SpecHandle = AbilitySystemComponent->MakeOutgoingSpec(EffectSnapshot.EffectClass, EffectSnapshot.Level, AbilitySystemComponent->MakeEffectContext());
+		FGameplayEffectSpec* Spec = SpecHandle.Data.Get();
+		if (Spec == nullptr) continue;
+
+		for (const TPair<FGameplayTag, float>& SetByCaller : EffectSnapshot.SetByCallerMagnitudes)
+		{
+			Spec->SetSetByCallerMagnitude(SetByCaller.Key, SetByCaller.Value);
+		}
+		Spec->SetStackCount(EffectSnapshot.StackCount);
+		if (EffectSnapshot.TimeRemaining != FGameplayEffectConstants::INFINITE_DURATION)
+		{
+			Spec->SetDuration(EffectSnapshot.TimeRemaining, true);
+		}
+		AbilitySystemComponent->ApplyGameplayEffectSpecToSelf(*Spec);
+	}
+	// Vitals are clamped to their maximums, which only settle once the primary attributes and effects are back.
+	RestoreBaseValues();
+}
+
+void UTopDownCrowdSubsystem::AddInstance(const FMassEntityHandle& Entity, UStaticMesh* ProxyMesh, const FTransform& Transform)
+{
+#if TOPDOWN_WITH_COSMETICS
+	// A dedicated server has nobody to show the proxies to.
+	if (ProxyMesh == nullptr || GetWorld()->GetNetMode() == NM_DedicatedServer) return;
+
+	const AEnemyCharacter* EnemyDefaults = EntityManager->GetFragmentDataChecked<FTopDownCrowdClassFragment>(Entity).EnemyClass->GetDefaultObject<AEnemyCharacter>();
+
+	if (VisualHost == nullptr)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		VisualHost = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+		USceneComponent* Root = NewObject<USceneComponent>(VisualHost);
+		VisualHost->SetRootComponent(Root);
+		Root->RegisterComponent();
+	}
+
+	FTopDownCrowdVisualBatch& Batch = VisualBatches.FindOrAdd(ProxyMesh);
+	if (Batch.InstancedMesh == nullptr)
+	{
+		Batch.InstancedMesh = NewObject<UInstancedStaticMeshComponent>(VisualHost);
+		Batch.InstancedMesh->SetStaticMesh(ProxyMesh);
+		Batch.InstancedMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		// Removing an instance moves the last one into its slot, the entity behind it is fixed up in RemoveInstance.
+		Batch.InstancedMesh->bSupportRemoveAtSwap = true;
+		Batch.InstancedMesh->SetupAttachment(VisualHost->GetRootComponent());
+		Batch.InstancedMesh->RegisterComponent();
+	}
+
+	FTopDownCrowdVisualFragment& Visual = EntityManager->GetFragmentDataChecked<FTopDownCrowdVisualFragment>(Entity);
+	Visual.ProxyMesh = ProxyMesh;
+	Visual.InstanceIndex = Batch.InstancedMesh->AddInstance(EnemyDefaults->GetCrowdProxyTransform() * Transform, true);
+	Batch.InstanceEntities.Add(Entity);
+#endif
+}
+
+void UTopDownCrowdSubsystem::RemoveInstance(const FTopDownCrowdVisualFragment& Visual)
+{
+#if TOPDOWN_WITH_COSMETICS
+	FTopDownCrowdVisualBatch* Batch = Visual.InstanceIndex != INDEX_NONE ? VisualBatches.Find(Visual.ProxyMesh.Get()) : nullptr;
+	if (Batch == nullptr || Batch->InstancedMesh == nullptr) return;
+
+	const int32 LastIndex = Batch->InstanceEntities.Num() - 1;
+	Batch->InstancedMesh->RemoveInstance(Visual.InstanceIndex);
+	if (Visual.InstanceIndex != LastIndex)
+	{
+		const FMassEntityHandle MovedEntity = Batch->InstanceEntities[LastIndex];
+		EntityManager->GetFragmentDataChecked<FTopDownCrowdVisualFragment>(MovedEntity).InstanceIndex = Visual.InstanceIndex;
+	}
+	Batch->InstanceEntities.RemoveAtSwap(Visual.InstanceIndex, 1, EAllowShrinking::No);
+#endif
+}
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystem/TopDownHealthBarSubsystem.h"
+
+#include "CanvasItem.h"
+#include "Engine/Canvas.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+
+DECLARE_CYCLE_STAT(TEXT("Health Bar Draw"), STAT_HealthBarDraw, STATGROUP_TopDown);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Bars Drawn"), STAT_HealthBarsDrawn, STATGROUP_TopDown);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Bars Culled"), STAT_HealthBarsCulled, STATGROUP_TopDown);
+
+void UTopDownHealthBarSubsystem::RegisterActor(AActor* Actor, float Health, float MaxHealth, float HeightOffset)
+{
+	if (!IsValid(Actor) || EntryIndices.Contains(Actor)) return;
+
+	const int32 EntryIndex = Entries.AddDefaulted();
+	FHealthBarEntry& Entry = Entries[EntryIndex];
+	Entry.Actor = Actor;
+	Entry.ActorKey = Actor;
+	Entry.Health = Health;
+	Entry.MaxHealth = MaxHealth;
+	Entry.HeightOffset = HeightOffset;
+
+	EntryIndices.Add(Actor, EntryIndex);
+}
+
+void UTopDownHealthBarSubsystem::UnregisterActor(AActor* Actor)
+{
+	if (const int32* EntryIndex = EntryIndices.Find(Actor))
+	{
+		RemoveEntry(*EntryIndex);
+	}
+}
+
+void UTopDownHealthBarSubsystem::SetHealth(const AActor* Actor, float Health)
+{
+	if (FHealthBarEntry* Entry = FindEntry(Actor))
+	{
+		Entry->Health = Health;
+		Entry->bDirty = true;
+	}
+}
+
+void UTopDownHealthBarSubsystem::SetMaxHealth(const AActor* Actor, float MaxHealth)
+{
+	if (FHealthBarEntry* Entry = FindEntry(Actor))
+	{
+		Entry->MaxHealth = MaxHealth;
+		Entry->bDirty = true;
+	}
+}
+
+void UTopDownHealthBarSubsystem::SetHidden(const AActor* Actor, bool bHidden)
+{
+	if (FHealthBarEntry* Entry = FindEntry(Actor))
+	{
+		Entry->bHidden = bHidden;
+	}
+}
+
+void UTopDownHealthBarSubsystem::DrawHealthBars(UCanvas* Canvas, const FTopDownHealthBarStyle& Style)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HealthBarDraw);
+
+	if (Canvas == nullptr || Canvas->Canvas == nullptr) return;
+
+	// Every bar is a white texture tile, so the canvas puts them all into a single batch.
+	FCanvasTileItem TileItem(FVector2D::ZeroVector, GWhiteTexture, Style.Size, FLinearColor::White);
+	TileItem.BlendMode = SE_BLEND_Translucent;
+
+	const FVector2D HalfSize = Style.Size * 0.5f;
+	int32 NumDrawn = 0;
+	int32 NumCulled = 0;
+
+	for (int32 EntryIndex = Entries.Num() - 1; EntryIndex >= 0; --EntryIndex)
+	{
+		FHealthBarEntry& Entry = Entries[EntryIndex];
+		const AActor* Actor = Entry.Actor.Get();
+		if (Actor == nullptr)
+		{
+			RemoveEntry(EntryIndex);
+			continue;
+		}
+		if (Entry.bHidden) continue;
+
+		if (Entry.bDirty)
+		{
+			Entry.Fill = Entry.MaxHealth > 0.f ? FMath::Clamp(Entry.Health / Entry.MaxHealth, 0.f, 1.f) : 0.f;
+			Entry.bDirty = false;
+		}
+
+		// Project returns Z <= 0 for points behind the camera.
+		const FVector ScreenPosition = Canvas->Project(Actor->GetActorLocation() + FVector(0.f, 0.f, Entry.HeightOffset));
+		const FVector2D BarCenter = FVector2D(ScreenPosition.X, ScreenPosition.Y) + Style.ScreenOffset;
+		if (ScreenPosition.Z <= 0.f ||
+			BarCenter.X + HalfSize.X < 0.f || BarCenter.X - HalfSize.X > Canvas->ClipX ||
+			BarCenter.Y + HalfSize.Y < 0.f || BarCenter.Y - HalfSize.Y > Canvas->ClipY)
+		{
+			++NumCulled;
+			continue;
+		}
+
+		const FVector2D BarPosition = BarCenter - HalfSize;
+
+		TileItem.Position = BarPosition;
+		TileItem.Size = Style.Size;
+		TileItem.SetColor(Style.BackgroundColor);
+		Canvas->DrawItem(TileItem);
+
+		if (Entry.Fill > 0.f)
+		{
+			TileItem.Size = FVector2D(Style.Size.X * Entry.Fill, Style.Size.Y);
+			TileItem.SetColor(Style.FillColor);
+			Canvas->DrawItem(TileItem);
+		}
+		++NumDrawn;
+	}
+
+	SET_DWORD_STAT(STAT_HealthBarsDrawn, NumDrawn);
+	SET_DWORD_STAT(STAT_HealthBarsCulled, NumCulled);
+}
+
+bool UTopDownHealthBarSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UTopDownHealthBarSubsystem::FHealthBarEntry* UTopDownHealthBarSubsystem::FindEntry(const AActor* Actor)
+{
+	const int32* EntryIndex = EntryIndices.Find(Actor);
+	return EntryIndex ? &Entries[*EntryIndex] : nullptr;
+}
+
+void UTopDownHealthBarSubsystem::RemoveEntry(int32 EntryIndex)
+{
+	EntryIndices.Remove(Entries[EntryIndex].ActorKey);
+
+	// Swap the last entry into the hole and point its index at the new slot.
+	const int32 LastIndex = Entries.Num() - 1;
+	if (EntryIndex != LastIndex)
+	{
+		EntryIndices.Add(Entries[LastIndex].ActorKey, EntryIndex);
+	}
+	Entries.RemoveAtSwap(EntryIndex, 1, EAllowShrinking::No);
+}
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystem/TopDownProjectilePoolSubsystem.h"
+
+#include "Actor/TopDownProjectile.h"
+#include "RPG_TopDown/RPG_TopDown.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectile Pool Hits"), STAT_ProjectilePoolHits, STATGROUP_TopDown);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectile Pool Misses"), STAT_ProjectilePoolMisses, STATGROUP_TopDown);
+
+static TAutoConsoleVariable<bool> CVarProjectilePoolEnabled(
+	TEXT("TopDown.ProjectilePool.Enabled"),
+	true,
+	TEXT("Recycle projectile actors instead of spawning and destroying one per shot."));
+
+void UTopDownProjectilePoolSubsystem::PrewarmPool(TSubclassOf<ATopDownProjectile> ProjectileClass, int32 Count)
+{
+	if (ProjectileClass == nullptr || !IsPoolingEnabled() || GetWorld()->GetNetMode() == NM_Client) return;
+
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+	Count = FMath::Min(Count, Pool.MaxParked);
+	
+	const FTransform ParkingTransform(FVector(0.f, 0.f, -100000.f));
+	while (Pool.ParkedProjectiles.Num() < Count)
+	{
+		ATopDownProjectile* Projectile = SpawnPooledProjectile(ProjectileClass, ParkingTransform, nullptr, nullptr);
+		Projectile->FinishSpawning(ParkingTransform);
+		Projectile->DeactivatePooledProjectile();
+		Pool.ParkedProjectiles.Add(Projectile);
+	}
+	Pool.Stats.Parked = Pool.ParkedProjectiles.Num();
+}
+
+void UTopDownProjectilePoolSubsystem::SetMaxPoolSize(TSubclassOf<ATopDownProjectile> ProjectileClass, int32 MaxParked)
+{
+	if (ProjectileClass == nullptr) return;
+	
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+	Pool.MaxParked = FMath::Max(MaxParked, 0);
+	while (Pool.ParkedProjectiles.Num() > Pool.MaxParked)
+	{
+		if (ATopDownProjectile* Projectile = Pool.ParkedProjectiles.Pop(EAllowShrinking::No))
+		{
+			Projectile->Destroy();
+		}
+	}
+	Pool.Stats.Parked = Pool.ParkedProjectiles.Num();
+}
+
+FProjectilePoolStats UTopDownProjectilePoolSubsystem::GetPoolStats(TSubclassOf<ATopDownProjectile> ProjectileClass) const
+{
+	const FProjectilePool* Pool = Pools.Find(ProjectileClass);
+	return Pool ? Pool->Stats : FProjectilePoolStats();
+}
+
+ATopDownProjectile* UTopDownProjectilePoolSubsystem::SpawnProjectileDeferred(TSubclassOf<ATopDownProjectile> ProjectileClass,
+	const FTransform& SpawnTransform, AActor* Owner, APawn* Instigator)
+{
+	check(ProjectileClass);
+	
+	if (!IsPoolingEnabled())
+	{
+		return GetWorld()->SpawnActorDeferred<ATopDownProjectile>(ProjectileClass, SpawnTransform, Owner, Instigator, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	}
+
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+	ATopDownProjectile* Projectile = nullptr;
+	
+	// Parked projectiles can still be destroyed from the outside, e.g. by a level unload.
+	while (Projectile == nullptr && !Pool.ParkedProjectiles.IsEmpty())
+	{
+		Projectile = Pool.ParkedProjectiles.Pop(EAllowShrinking::No);
+		Projectile = IsValid(Projectile) ? Projectile : nullptr;
+	}
+	
+	if (Projectile)
+	{
+		Projectile->SetOwner(Owner);
+		Projectile->SetInstigator(Instigator);
+		++Pool.Stats.Hits;
+		INC_DWORD_STAT(STAT_ProjectilePoolHits);
+	}
+	else
+	{
+		Projectile = SpawnPooledProjectile(ProjectileClass, SpawnTransform, Owner, Instigator);
+		++Pool.Stats.Misses;
+		INC_DWORD_STAT(STAT_ProjectilePoolMisses);
+	}
+	
+	Pool.Stats.Active++;
+	Pool.Stats.HighWaterMark = FMath::Max(Pool.Stats.HighWaterMark, Pool.Stats.Active);
+	Pool.Stats.Parked = Pool.ParkedProjectiles.Num();
+	return Projectile;
+}
+
+void UTopDownProjectilePoolSubsystem::FinishSpawningProjectile(ATopDownProjectile* Projectile, const FTransform& SpawnTransform)
+{
+	check(Projectile);
+	
+	if (!Projectile->HasActorBegunPlay())
+	{
+		Projectile->FinishSpawning(SpawnTransform);
+	}
+	if (Projectile->IsPooled())
+	{
+		Projectile->ActivatePooledProjectile(SpawnTransform);
+	}
+}
+
+void UTopDownProjectilePoolSubsystem::ReleaseProjectile(ATopDownProjectile* Projectile)
+{
+	check(Projectile && Projectile->IsPooled());
+
+	FProjectilePool& Pool = Pools.FindOrAdd(Projectile->GetClass());
+	Pool.Stats.Active = FMath::Max(Pool.Stats.Active - 1, 0);
+	
+	if (!IsPoolingEnabled() || Pool.ParkedProjectiles.Num() >= Pool.MaxParked)
+	{
+		Projectile->Destroy();
+		return;
+	}
+	
+	Projectile->DeactivatePooledProjectile();
+	Pool.ParkedProjectiles.Add(Projectile);
+	Pool.Stats.Parked = Pool.ParkedProjectiles.Num();
+}
+
+bool UTopDownProjectilePoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UTopDownProjectilePoolSubsystem::IsPoolingEnabled()
+{
+	return CVarProjectilePoolEnabled.GetValueOnGameThread();
+}
+
+ATopDownProjectile* UTopDownProjectilePoolSubsystem::SpawnPooledProjectile(TSubclassOf<ATopDownProjectile> ProjectileClass,
+	const FTransform& SpawnTransform, AActor* Owner, APawn* Instigator) const
+{
+	ATopDownProjectile* Projectile = GetWorld()->SpawnActorDeferred<ATopDownProjectile>(ProjectileClass, SpawnTransform, Owner, Instigator,
+		ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	Projectile->MarkPooled();
+	return Projectile;
+}
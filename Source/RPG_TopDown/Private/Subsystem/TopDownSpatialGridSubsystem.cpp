@@ -0,0 +1,276 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystem/TopDownSpatialGridSubsystem.h"
+
+#include "RPG_TopDown/RPG_TopDown.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spatial Grid Update"), STAT_SpatialGridUpdate, STATGROUP_TopDown);
+DECLARE_CYCLE_STAT(TEXT("Spatial Grid Query"), STAT_SpatialGridQuery, STATGROUP_TopDown);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spatial Grid Entries"), STAT_SpatialGridEntries, STATGROUP_TopDown);
+
+static TAutoConsoleVariable<float> CVarSpatialGridCellSize(
+	TEXT("TopDown.SpatialGrid.CellSize"),
+	500.f,
+	TEXT("Cell size in cm of the character spatial grid. Read when a world starts."));
+
+void UTopDownSpatialGridSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CellSize = FMath::Max(CVarSpatialGridCellSize.GetValueOnGameThread(), 50.f);
+}
+
+void UTopDownSpatialGridSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpatialGridUpdate);
+	
+	float NewMinZ = TNumericLimits<float>::Max();
+	float NewMaxZ = TNumericLimits<float>::Lowest();
+	
+	for (int32 EntryIndex = Entries.Num() - 1; EntryIndex >= 0; --EntryIndex)
+	{
+		FSpatialGridEntry& Entry = Entries[EntryIndex];
+		const AActor* Actor = Entry.Actor.Get();
+		if (Actor == nullptr)
+		{
+			RemoveEntry(EntryIndex);
+			continue;
+		}
+
+		Entry.Location = Actor->GetActorLocation();
+		const FIntPoint NewCell = GetCell(Entry.Location);
+		if (NewCell != Entry.Cell)
+		{
+			RemoveFromCell(EntryIndex);
+			Entry.Cell = NewCell;
+			AddToCell(EntryIndex);
+		}
+		
+		NewMinZ = FMath::Min(NewMinZ, static_cast<float>(Entry.Location.Z) - Entry.HalfHeight);
+		NewMaxZ = FMath::Max(NewMaxZ, static_cast<float>(Entry.Location.Z) + Entry.HalfHeight);
+	}
+	
+	MinZ = NewMinZ;
+	MaxZ = NewMaxZ;
+	SET_DWORD_STAT(STAT_SpatialGridEntries, Entries.Num());
+}
+
+TStatId UTopDownSpatialGridSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownSpatialGridSubsystem, STATGROUP_Tickables);
+}
+
+void UTopDownSpatialGridSubsystem::RegisterActor(AActor* Actor, float Radius, float HalfHeight)
+{
+	if (!IsValid(Actor) || EntryIndices.Contains(Actor)) return;
+
+	const int32 EntryIndex = Entries.AddDefaulted();
+	FSpatialGridEntry& Entry = Entries[EntryIndex];
+	Entry.Actor = Actor;
+	Entry.ActorKey = Actor;
+	Entry.Location = Actor->GetActorLocation();
+	Entry.Cell = GetCell(Entry.Location);
+	Entry.Radius = Radius;
+	Entry.HalfHeight = HalfHeight;
+	
+	EntryIndices.Add(Actor, EntryIndex);
+	AddToCell(EntryIndex);
+	
+	MaxEntryRadius = FMath::Max(MaxEntryRadius, Radius);
+	MinZ = FMath::Min(MinZ, static_cast<float>(Entry.Location.Z) - HalfHeight);
+	MaxZ = FMath::Max(MaxZ, static_cast<float>(Entry.Location.Z) + HalfHeight);
+}
+
+void UTopDownSpatialGridSubsystem::UnregisterActor(AActor* Actor)
+{
+	if (const int32* EntryIndex = EntryIndices.Find(Actor))
+	{
+		RemoveEntry(*EntryIndex);
+	}
+}
+
+template<typename FunctorType>
+void UTopDownSpatialGridSubsystem::ForEachEntryInBox(const FVector2D& Min, const FVector2D& Max, FunctorType&& Visitor) const
+{
+	const FIntPoint MinCell = GetCell(FVector(Min - MaxEntryRadius, 0.f));
+	const FIntPoint MaxCell = GetCell(FVector(Max + MaxEntryRadius, 0.f));
+
+	// A huge box touches more cells than there are occupied ones, walk the occupied cells instead.
+	const int64 CellsInBox = static_cast<int64>(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1);
+	if (CellsInBox > Cells.Num())
+	{
+		for (const TPair<FIntPoint, TArray<int32>>& Cell : Cells)
+		{
+			if (Cell.Key.X < MinCell.X || Cell.Key.X > MaxCell.X || Cell.Key.Y < MinCell.Y || Cell.Key.Y > MaxCell.Y) continue;
+			for (const int32 EntryIndex : Cell.Value)
+			{
+				Visitor(Entries[EntryIndex]);
+			}
+		}
+		return;
+	}
+	
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			if (const TArray<int32>* CellEntries = Cells.Find(FIntPoint(X, Y)))
+			{
+				for (const int32 EntryIndex : *CellEntries)
+				{
+					Visitor(Entries[EntryIndex]);
+				}
+			}
+		}
+	}
+}
+
+void UTopDownSpatialGridSubsystem::QueryRadius(const FVector& Origin, float Radius, TArray<AActor*>& OutActors, TSubclassOf<AActor> ActorClassFilter) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpatialGridQuery);
+	OutActors.Reset();
+	
+	const FVector2D Origin2D(Origin);
+	ForEachEntryInBox(Origin2D - Radius, Origin2D + Radius, [&](const FSpatialGridEntry& Entry)
+	{
+		const float ReachSquared = FMath::Square(Radius + Entry.Radius);
+		if (FVector2D::DistSquared(Origin2D, FVector2D(Entry.Location)) > ReachSquared) return;
+
+		AActor* Actor = Entry.Actor.Get();
+		if (Actor && (ActorClassFilter == nullptr || Actor->IsA(ActorClassFilter)))
+		{
+			OutActors.Add(Actor);
+		}
+	});
+}
+
+void UTopDownSpatialGridSubsystem::QueryCone(const FVector& Origin, const FVector& Direction, float Length, float HalfAngleDegrees,
+	TArray<AActor*>& OutActors, TSubclassOf<AActor> ActorClassFilter) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpatialGridQuery);
+	OutActors.Reset();
+
+	const FVector2D Origin2D(Origin);
+	const FVector2D Direction2D = FVector2D(Direction).GetSafeNormal();
+	const float CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(HalfAngleDegrees));
+	
+	ForEachEntryInBox(Origin2D - Length, Origin2D + Length, [&](const FSpatialGridEntry& Entry)
+	{
+		const FVector2D ToEntry = FVector2D(Entry.Location) - Origin2D;
+		const float Distance = ToEntry.Size();
+		if (Distance > Length + Entry.Radius) return;
+		
+		// An entry standing on the apex is always inside.
+		if (Distance > Entry.Radius && FVector2D::DotProduct(ToEntry / Distance, Direction2D) < CosHalfAngle) return;
+
+		AActor* Actor = Entry.Actor.Get();
+		if (Actor && (ActorClassFilter == nullptr || Actor->IsA(ActorClassFilter)))
+		{
+			OutActors.Add(Actor);
+		}
+	});
+}
+
+AActor* UTopDownSpatialGridSubsystem::RayPick(const FVector& RayStart, const FVector& RayEnd, TSubclassOf<AActor> ActorClassFilter) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpatialGridQuery);
+	if (Entries.IsEmpty()) return nullptr;
+
+	// Clip the ray to the vertical band the capsules live in. A cursor ray is long, but only a short piece of it can hit anything.
+	FVector ClippedStart = RayStart;
+	FVector ClippedEnd = RayEnd;
+	const double DeltaZ = RayEnd.Z - RayStart.Z;
+	if (!FMath::IsNearlyZero(DeltaZ))
+	{
+		const double TMinZ = (MinZ - RayStart.Z) / DeltaZ;
+		const double TMaxZ = (MaxZ - RayStart.Z) / DeltaZ;
+		const double TEnter = FMath::Clamp(FMath::Min(TMinZ, TMaxZ), 0.0, 1.0);
+		const double TExit = FMath::Clamp(FMath::Max(TMinZ, TMaxZ), 0.0, 1.0);
+		if (TEnter >= TExit) return nullptr;
+		
+		ClippedStart = RayStart + (RayEnd - RayStart) * TEnter;
+		ClippedEnd = RayStart + (RayEnd - RayStart) * TExit;
+	}
+	else if (RayStart.Z < MinZ || RayStart.Z > MaxZ)
+	{
+		return nullptr;
+	}
+
+	const FVector2D BoxMin(FMath::Min(ClippedStart.X, ClippedEnd.X), FMath::Min(ClippedStart.Y, ClippedEnd.Y));
+	const FVector2D BoxMax(FMath::Max(ClippedStart.X, ClippedEnd.X), FMath::Max(ClippedStart.Y, ClippedEnd.Y));
+	
+	AActor* ClosestActor = nullptr;
+	double ClosestDistanceSquared = TNumericLimits<double>::Max();
+	ForEachEntryInBox(BoxMin, BoxMax, [&](const FSpatialGridEntry& Entry)
+	{
+		// Closest points between the ray and the capsule's axis.
+		const FVector AxisOffset(0.f, 0.f, FMath::Max(Entry.HalfHeight - Entry.Radius, 0.f));
+		FVector PointOnRay;
+		FVector PointOnAxis;
+		FMath::SegmentDistToSegmentSafe(ClippedStart, ClippedEnd, Entry.Location - AxisOffset, Entry.Location + AxisOffset, PointOnRay, PointOnAxis);
+		if (FVector::DistSquared(PointOnRay, PointOnAxis) > FMath::Square(Entry.Radius)) return;
+
+		const double DistanceSquared = FVector::DistSquared(RayStart, PointOnRay);
+		if (DistanceSquared >= ClosestDistanceSquared) return;
+		
+		AActor* Actor = Entry.Actor.Get();
+		if (Actor && (ActorClassFilter == nullptr || Actor->IsA(ActorClassFilter)))
+		{
+			ClosestActor = Actor;
+			ClosestDistanceSquared = DistanceSquared;
+		}
+	});
+	return ClosestActor;
+}
+
+bool UTopDownSpatialGridSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FIntPoint UTopDownSpatialGridSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+void UTopDownSpatialGridSubsystem::AddToCell(int32 EntryIndex)
+{
+	Cells.FindOrAdd(Entries[EntryIndex].Cell).Add(EntryIndex);
+}
+
+void UTopDownSpatialGridSubsystem::RemoveFromCell(int32 EntryIndex)
+{
+	const FIntPoint Cell = Entries[EntryIndex].Cell;
+	if (TArray<int32>* CellEntries = Cells.Find(Cell))
+	{
+		CellEntries->RemoveSingleSwap(EntryIndex, EAllowShrinking::No);
+		if (CellEntries->IsEmpty())
+		{
+			Cells.Remove(Cell);
+		}
+	}
+}
+
+void UTopDownSpatialGridSubsystem::RemoveEntry(int32 EntryIndex)
+{
+	RemoveFromCell(EntryIndex);
+	EntryIndices.Remove(Entries[EntryIndex].ActorKey);
+	
+	// Swap the last entry into the hole and fix up the indices pointing at it.
+	const int32 LastIndex = Entries.Num() - 1;
+	if (EntryIndex != LastIndex)
+	{
+		FSpatialGridEntry& LastEntry = Entries[LastIndex];
+		if (TArray<int32>* CellEntries = Cells.Find(LastEntry.Cell))
+		{
+			const int32 SlotInCell = CellEntries->Find(LastIndex);
+			if (SlotInCell != INDEX_NONE)
+			{
+				(*CellEntries)[SlotInCell] = EntryIndex;
+			}
+		}
+		EntryIndices.Add(LastEntry.ActorKey, EntryIndex);
+	}
+	Entries.RemoveAtSwap(EntryIndex, 1, EAllowShrinking::No);
+}
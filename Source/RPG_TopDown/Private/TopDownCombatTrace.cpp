@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownCombatTrace.h"
+
+#if TOPDOWN_COMBAT_TRACE_ENABLED
+
+#include "AbilitySystemComponent.h"
+#include "GameplayEffect.h"
+
+UE_TRACE_CHANNEL_DEFINE(TopDownCombatChannel)
+
+UE_TRACE_EVENT_BEGIN(TopDownCombat, HealthChanged)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, TargetId)
+	UE_TRACE_EVENT_FIELD(float, Health)
+	UE_TRACE_EVENT_FIELD(float, MaxHealth)
+	UE_TRACE_EVENT_FIELD(float, Magnitude)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, TargetName)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TopDownCombat, GameplayEffectChanged)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, TargetId)
+	UE_TRACE_EVENT_FIELD(int32, ActiveCount)
+	UE_TRACE_EVENT_FIELD(bool, bRemoved)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, TargetName)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, EffectName)
+UE_TRACE_EVENT_END()
+
+void FTopDownCombatTrace::OutputHealthChanged(const AActor* TargetActor, const float Health, const float MaxHealth, const float Magnitude)
+{
+	const FString TargetName = GetNameSafe(TargetActor);
+	UE_TRACE_LOG(TopDownCombat, HealthChanged, TopDownCombatChannel)
+		<< HealthChanged.Cycle(FPlatformTime::Cycles64())
+		<< HealthChanged.TargetId(TargetActor ? TargetActor->GetUniqueID() : 0)
+		<< HealthChanged.Health(Health)
+		<< HealthChanged.MaxHealth(MaxHealth)
+		<< HealthChanged.Magnitude(Magnitude)
+		<< HealthChanged.TargetName(*TargetName, TargetName.Len());
+}
+
+void FTopDownCombatTrace::OutputGameplayEffectChanged(const UAbilitySystemComponent* TargetAbilitySystemComponent, TSubclassOf<UGameplayEffect> GameplayEffectClass, const bool bRemoved)
+{
+	if (TargetAbilitySystemComponent == nullptr) return;
+
+	const AActor* TargetActor = TargetAbilitySystemComponent->GetAvatarActor();
+	const FString TargetName = GetNameSafe(TargetActor);
+	const FString EffectName = GetNameSafe(GameplayEffectClass);
+	UE_TRACE_LOG(TopDownCombat, GameplayEffectChanged, TopDownCombatChannel)
+		<< GameplayEffectChanged.Cycle(FPlatformTime::Cycles64())
+		<< GameplayEffectChanged.TargetId(TargetActor ? TargetActor->GetUniqueID() : 0)
+		<< GameplayEffectChanged.ActiveCount(TargetAbilitySystemComponent->GetGameplayEffectCount(GameplayEffectClass, nullptr))
+		<< GameplayEffectChanged.bRemoved(bRemoved)
+		<< GameplayEffectChanged.TargetName(*TargetName, TargetName.Len())
+		<< GameplayEffectChanged.EffectName(*EffectName, EffectName.Len());
+}
+
+#endif
@@ -1,7 +1,187 @@
 
 #include "TopDownCustomAbilityTypes.h"
 
+#include "Abilities/GameplayAbility.h"
+#include "GameFramework/Character.h"
+#include "Serialization/BitWriter.h"
+
+static TAutoConsoleVariable<bool> CVarCompactEffectContext(
+	TEXT("TopDown.EffectContext.CompactNetSerialize"),
+	true,
+	TEXT("Send FTopDownGameplayEffectContext in the compact wire format. Only affects the sending side, the format travels with the data."));
+
 bool FTopDownGameplayEffectContext::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 bCompact = Ar.IsSaving() && CVarCompactEffectContext.GetValueOnAnyThread() ? 1 : 0;
+	Ar.SerializeBits(&bCompact, 1);
+	return bCompact ? NetSerializeCompact(Ar, Map, bOutSuccess) : NetSerializeLegacy(Ar, Map, bOutSuccess);
+}
+
+bool FTopDownGameplayEffectContext::NetSerializeCompact(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	enum ECompactRepBits : uint32
+	{
+		Rep_Instigator				= 1 << 0,
+		Rep_EffectCauser			= 1 << 1,
+		Rep_EffectCauserIsInstigator= 1 << 2,
+		Rep_AbilityCDO				= 1 << 3,
+		Rep_SourceObject			= 1 << 4,
+		Rep_Actors					= 1 << 5,
+		Rep_ActorsAreSourceObject	= 1 << 6,
+		Rep_HitResult				= 1 << 7,
+		Rep_HitLocation				= 1 << 8,
+		Rep_HitImpactPoint			= 1 << 9,
+		Rep_WorldOrigin				= 1 << 10,
+		Rep_Evaded					= 1 << 11,
+		Rep_CriticalHit				= 1 << 12,
+		Rep_BlockedHit				= 1 << 13,
+		
+		Rep_NumBits					= 14
+	};
+	
+	uint32 RepBits = 0;
+	if (Ar.IsSaving())
+	{
+		const bool bHasInstigator = bReplicateInstigator && Instigator.IsValid();
+		if (bHasInstigator)
+		{
+			RepBits |= Rep_Instigator;
+		}
+		if (bReplicateEffectCauser && EffectCauser.IsValid())
+		{
+			// Usually the instigator is its own effect causer, the receiver can copy it over.
+			RepBits |= bHasInstigator && EffectCauser == Instigator ? Rep_EffectCauserIsInstigator : Rep_EffectCauser;
+		}
+		if (AbilityCDO.IsValid())
+		{
+			RepBits |= Rep_AbilityCDO;
+		}
+		const bool bHasSourceObject = bReplicateSourceObject && SourceObject.IsValid();
+		if (bHasSourceObject)
+		{
+			RepBits |= Rep_SourceObject;
+		}
+		if (Actors.Num() > 0)
+		{
+			// Projectiles add themselves as both the source object and the only actor.
+			const bool bActorsAreSourceObject = bHasSourceObject && Actors.Num() == 1 && Actors[0].Get() == SourceObject.Get();
+			RepBits |= bActorsAreSourceObject ? Rep_ActorsAreSourceObject : Rep_Actors;
+		}
+		if (HitResult.IsValid())
+		{
+			if (bReplicateFullHitResult)
+			{
+				RepBits |= Rep_HitResult;
+			}
+			else
+			{
+				RepBits |= Rep_HitLocation;
+				if (HitResult->ImpactPoint != HitResult->Location)
+				{
+					RepBits |= Rep_HitImpactPoint;
+				}
+			}
+		}
+		if (bHasWorldOrigin)
+		{
+			RepBits |= Rep_WorldOrigin;
+		}
+		if (bIsEvaded)
+		{
+			RepBits |= Rep_Evaded;
+		}
+		if (bIsCriticalHit)
+		{
+			RepBits |= Rep_CriticalHit;
+		}
+		if (bIsBlockedHit)
+		{
+			RepBits |= Rep_BlockedHit;
+		}
+	}
+
+	Ar.SerializeBits(&RepBits, Rep_NumBits);
+
+	if (RepBits & Rep_Instigator)
+	{
+		Ar << Instigator;
+	}
+	if (RepBits & Rep_EffectCauser)
+	{
+		Ar << EffectCauser;
+	}
+	if (RepBits & Rep_AbilityCDO)
+	{
+		Ar << AbilityCDO;
+	}
+	if (RepBits & Rep_SourceObject)
+	{
+		Ar << SourceObject;
+	}
+	if (RepBits & Rep_Actors)
+	{
+		SafeNetSerializeTArray_Default<31>(Ar, Actors);
+	}
+	if (RepBits & (Rep_HitResult | Rep_HitLocation))
+	{
+		if (Ar.IsLoading() && !HitResult.IsValid())
+		{
+			HitResult = TSharedPtr<FHitResult>(new FHitResult());
+		}
+		if (RepBits & Rep_HitResult)
+		{
+			HitResult->NetSerialize(Ar, Map, bOutSuccess);
+		}
+		else
+		{
+			FVector_NetQuantize10 HitLocation = HitResult->Location;
+			HitLocation.NetSerialize(Ar, Map, bOutSuccess);
+			FVector_NetQuantize10 HitImpactPoint = HitLocation;
+			if (RepBits & Rep_HitImpactPoint)
+			{
+				HitImpactPoint = HitResult->ImpactPoint;
+				HitImpactPoint.NetSerialize(Ar, Map, bOutSuccess);
+			}
+			if (Ar.IsLoading())
+			{
+				HitResult->Location = HitLocation;
+				HitResult->ImpactPoint = HitImpactPoint;
+			}
+		}
+	}
+	if (RepBits & Rep_WorldOrigin)
+	{
+		Ar << WorldOrigin;
+	}
+
+	if (Ar.IsLoading())
+	{
+		if (RepBits & Rep_EffectCauserIsInstigator)
+		{
+			EffectCauser = Instigator;
+		}
+		if (RepBits & Rep_ActorsAreSourceObject)
+		{
+			Actors.Reset();
+			Actors.Add(Cast<AActor>(SourceObject.Get()));
+		}
+		if (!(RepBits & (Rep_HitResult | Rep_HitLocation)))
+		{
+			HitResult.Reset();
+		}
+		bHasWorldOrigin = (RepBits & Rep_WorldOrigin) != 0;
+		bIsEvaded = (RepBits & Rep_Evaded) != 0;
+		bIsCriticalHit = (RepBits & Rep_CriticalHit) != 0;
+		bIsBlockedHit = (RepBits & Rep_BlockedHit) != 0;
+		
+		AddInstigator(Instigator.Get(), EffectCauser.Get()); // Just to initialize InstigatorAbilitySystemComponent
+	}
+	
+	bOutSuccess = true;
+	return true;
+}
+
+bool FTopDownGameplayEffectContext::NetSerializeLegacy(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
 {
 	//Super::NetSerialize(Ar, Map, bOutSuccess);
 	
@@ -115,3 +295,57 @@ bool FTopDownGameplayEffectContext::NetSerialize(FArchive& Ar, UPackageMap* Map,
 	bOutSuccess = true;
 	return true;
 }
+
+#if !UE_BUILD_SHIPPING
+namespace TopDownEffectContextWireSize
+{
+	// Bit writer that stands in a 32 bit NetGUID for every object reference, there is no package map outside of a connection.
+	class FWireSizeWriter : public FBitWriter
+	{
+	public:
+		FWireSizeWriter() : FBitWriter(0, true) { SetIsPersistent(false); }
+
+		virtual FArchive& operator<<(UObject*& Object) override
+		{
+			++ObjectReferences;
+			uint32 NetGUID = 0;
+			*this << NetGUID;
+			return *this;
+		}
+		using FArchive::operator<<;
+
+		int32 ObjectReferences = 0;
+	};
+
+	// Serializes the same context in both formats and logs their size.
+	static void Report()
+	{
+		// Set up the way UTopDownProjectileAbility::SpawnProjectile does it.
+		AActor* SourceAvatar = GetMutableDefault<ACharacter>();
+		AActor* Projectile = GetMutableDefault<AActor>();
+		FTopDownGameplayEffectContext EffectContext;
+		EffectContext.AddInstigator(SourceAvatar, SourceAvatar);
+		EffectContext.SetAbility(GetDefault<UGameplayAbility>());
+		EffectContext.AddSourceObject(Projectile);
+		EffectContext.AddActors({Projectile});
+		FHitResult HitResult;
+		HitResult.Location = FVector(1234.5f, -678.9f, 90.f);
+		EffectContext.AddHitResult(HitResult);
+		EffectContext.SetIsCriticalHit(true);
+
+		bool bSuccess = false;
+		FWireSizeWriter LegacyWriter;
+		EffectContext.NetSerializeLegacy(LegacyWriter, nullptr, bSuccess);
+		FWireSizeWriter CompactWriter;
+		EffectContext.NetSerializeCompact(CompactWriter, nullptr, bSuccess);
+
+		UE_LOG(LogTemp, Display, TEXT("FTopDownGameplayEffectContext projectile context: legacy %lld bits (%d object references), compact %lld bits (%d object references)."),
+			LegacyWriter.GetNumBits(), LegacyWriter.ObjectReferences, CompactWriter.GetNumBits(), CompactWriter.ObjectReferences);
+	}
+}
+
+static FAutoConsoleCommand CEffectContextWireSize(
+	TEXT("TopDown.EffectContext.WireSize"),
+	TEXT("Logs the serialized size of a projectile damage effect context in the legacy and compact formats."),
+	FConsoleCommandDelegate::CreateStatic(&TopDownEffectContextWireSize::Report));
+#endif
@@ -113,6 +113,9 @@ void FTopDownGameplayTags::InitializeNativeGameplayTags()
 	GameplayTags.Damage = UGameplayTagsManager::Get().AddNativeGameplayTag(FName("Damage"),
 	FString("Damage"));
 
+	GameplayTags.Damage_Resolved = UGameplayTagsManager::Get().AddNativeGameplayTag(FName("Damage.Resolved"),
+	FString("Set by caller magnitude holding damage that was already resolved by the batched damage path"));
+
 	GameplayTags.Effects_HitReact = UGameplayTagsManager::Get().AddNativeGameplayTag(FName("Effects.HitReact"),
 	FString("Tag granted when Hit Reacting"));
 }
@@ -79,3 +79,14 @@ void ATopDownHUD::InitializeOverlayWidget(APlayerController* PC, APlayerState* P
 	Widget->AddToViewport();
 }
 
+void ATopDownHUD::DrawHUD()
+{
+	Super::DrawHUD();
+
+	// Enemy health bars, all of them in one pass
+	if (UTopDownHealthBarSubsystem* HealthBarSubsystem = GetWorld()->GetSubsystem<UTopDownHealthBarSubsystem>())
+	{
+		HealthBarSubsystem->DrawHealthBars(Canvas, HealthBarStyle);
+	}
+}
+
@@ -3,3 +3,52 @@
 
 #include "UI/Widget/DamageTextWidgetComponent.h"
 
+#include "Controller/Player/PlayerCharacterController.h"
+
+void UDamageTextWidgetComponent::ShowDamageText(APlayerCharacterController* InOwningController, float Damage, bool bEvadedHit, bool bCriticalHit, bool bBlockChance)
+{
+	OwningController = InOwningController;
+	
+	SetVisibility(true);
+	SetComponentTickEnabled(true);
+	SetDamageText(Damage, bEvadedHit, bCriticalHit, bBlockChance);
+
+	if (DisplayDuration > 0.f)
+	{
+		GetWorld()->GetTimerManager().SetTimer(DisplayTimerHandle, this, &UDamageTextWidgetComponent::ReleaseToPool, DisplayDuration, false);
+	}
+}
+
+void UDamageTextWidgetComponent::ReleaseToPool()
+{
+	GetWorld()->GetTimerManager().ClearTimer(DisplayTimerHandle);
+	
+	SetVisibility(false);
+	SetComponentTickEnabled(false);
+
+	// Cleared first, the controller destroys the component for real when its pool is full.
+	APlayerCharacterController* Controller = OwningController.Get();
+	OwningController.Reset();
+	
+	if (Controller)
+	{
+		Controller->ReleaseDamageText(this);
+	}
+	else
+	{
+		DestroyComponent();
+	}
+}
+
+void UDamageTextWidgetComponent::DestroyComponent(bool bPromoteChildren)
+{
+	const AActor* Owner = GetOwner();
+	if (OwningController.IsValid() && Owner && !Owner->IsActorBeingDestroyed())
+	{
+		ReleaseToPool();
+		return;
+	}
+	
+	GetWorld()->GetTimerManager().ClearTimer(DisplayTimerHandle);
+	Super::DestroyComponent(bPromoteChildren);
+}
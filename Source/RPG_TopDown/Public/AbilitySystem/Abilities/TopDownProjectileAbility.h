@@ -18,14 +18,31 @@ class RPG_TOPDOWN_API UTopDownProjectileAbility : public UBaseGameplayAbility
 {
 	GENERATED_BODY()
 
+public:
+
+	// Spawns a projectile at ProjectileTargetLocation without going through the blueprint graph, which waits on cursor target data.
+	// For code that drives the ability itself, like UTopDownCombatSimulationSubsystem. Server only, same as SpawnProjectile.
+	void SpawnProjectileAtLocation(const FVector& ProjectileTargetLocation);
+
 protected:
 
+	// Prewarms the projectile pool on the server when the ability is granted.
+	virtual void OnGiveAbility(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec) override;
+
 	UFUNCTION(BlueprintCallable, Category="Projectile")
 	virtual void SpawnProjectile(const FVector& ProjectileTargetLocation);
 	
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Projectile")
 	TSubclassOf<ATopDownProjectile> ProjectileClass;
 
+	// How many projectiles of ProjectileClass are spawned up front and parked in the pool.
+	UPROPERTY(EditDefaultsOnly, Category="Projectile|Pool", meta=(ClampMin=0))
+	int32 ProjectilePoolPrewarmCount = 8;
+
+	// How many parked projectiles of ProjectileClass the pool keeps at most.
+	UPROPERTY(EditDefaultsOnly, Category="Projectile|Pool", meta=(ClampMin=0))
+	int32 ProjectilePoolMaxSize = 32;
+
 	// Variable for the damage effect
 	UPROPERTY(EditDefaultsOnly, Category="Projectile|GameplayEffect")
 	TSubclassOf<UGameplayEffect> DamageEffectClass;
@@ -30,10 +30,25 @@ public:
 	void ActivateAbilityInputTagHeld(const FGameplayTag& InputTag);
 	void ActivateAbilityInputTagReleased(const FGameplayTag& InputTag);
 
+	// Rebinds a granted ability to another input tag at runtime. Server only, the spec replicates to the owning client.
+	void SetAbilityInputTag(FGameplayAbilitySpecHandle AbilitySpecHandle, const FGameplayTag& InputTag);
+
 	FGameplayEffectAssetTags GameplayEffectAssetTags;
+
+	// Also wakes the owning player state's net update frequency up, see ATopDownPlayerState::MarkNetActivity.
+	virtual void ForceReplication() override;
+
+#if !UE_BUILD_SHIPPING
+	// Backs TopDown.AbilityInput.Benchmark. Grants AbilityCount abilities to a transient component and times input tag lookups.
+	static void RunInputDispatchBenchmark(int32 AbilityCount);
+#endif
 	
 protected:
 
+	virtual void OnGiveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+	virtual void OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+	virtual void OnRep_ActivateAbilities() override;
+
 	/*
 	 * Purpose: FOnGameplayEffectAppliedDelegate OnGameplayEffectAppliedDelegateToSelf Delegate
 	 * The delegate serves as an event notification system within the Gameplay Ability System.
@@ -47,4 +62,22 @@ protected:
 	// Client RPC, this function will be called in the server and executed on the client.
 	UFUNCTION(Client, Reliable)
 	void ClientEffectAppliedToSelf(UAbilitySystemComponent* AbilitySystemComponent, const FGameplayEffectSpec& GameplayEffectSpec, FActiveGameplayEffectHandle ActiveGameplayEffectHandle);
+
+private:
+
+	// Where an ability with a given input tag sits in the activatable abilities list.
+	struct FInputTagAbilitySpec
+	{
+		FGameplayAbilitySpecHandle Handle;
+		int32 SpecIndex = INDEX_NONE;
+	};
+	using FInputTagAbilitySpecArray = TArray<FInputTagAbilitySpec, TInlineAllocator<2>>;
+
+	// Input tag -> abilities lookup used for input dispatch. Rebuilt lazily after abilities were given, removed or replicated.
+	const FInputTagAbilitySpecArray* FindAbilitySpecsForInputTag(const FGameplayTag& InputTag);
+	FGameplayAbilitySpec* ResolveInputTagAbilitySpec(const FInputTagAbilitySpec& InputTagAbilitySpec);
+	void RebuildInputTagAbilitySpecs();
+	
+	TMap<FGameplayTag, FInputTagAbilitySpecArray> InputTagAbilitySpecs;
+	bool bInputTagAbilitySpecsDirty = true;
 };
@@ -7,6 +7,9 @@
 #include "AttributeSet.h"
 #include "BaseAttributeSet.generated.h"
 
+/* Forward Declaration */
+struct FGameplayEffectModCallbackData;
+
 // Now we have this attribute accessors macro. And if we call ATTRIBUTE_ACCESSORS, then we don't have to use all four of these.
 #define ATTRIBUTE_ACCESSORS(ClassName, PropertyName) \
 	GAMEPLAYATTRIBUTE_PROPERTY_GETTER(ClassName, PropertyName) \
@@ -53,22 +56,63 @@ struct FGameplayEffectContextInfo
 	ACharacter* Character = nullptr;
 };
 
-USTRUCT(BlueprintType)
+/*
+ * Source and target of the effect being executed, as PostGameplayEffectExecute sees them.
+ * Lives on the stack and only resolves a side the first time a branch asks for it,
+ * so regen ticks that just clamp a value never look up avatars, controllers or characters.
+ */
 struct FGameplayEffectContextDetails
+{
+	explicit FGameplayEffectContextDetails(const FGameplayEffectModCallbackData& InData);
+
+	const FGameplayEffectContextHandle& GetContextHandle() const { return GameplayEffectContextHandle; }
+	const FGameplayEffectContextInfo& GetSourceProperties();
+	const FGameplayEffectContextInfo& GetTargetProperties();
+
+private:
+
+	void ResolveSourceProperties();
+	void ResolveTargetProperties();
+
+	const FGameplayEffectModCallbackData& Data;
+	FGameplayEffectContextHandle GameplayEffectContextHandle;
+	FGameplayEffectContextInfo SourceProperties;
+	FGameplayEffectContextInfo TargetProperties;
+	bool bSourcePropertiesResolved = false;
+	bool bTargetPropertiesResolved = false;
+};
+
+/*
+ * Health, Mana, Stamina and their maximums as everyone but the owner sees them.
+ * Non-owners only need these for health bars, so they are sent as packed fixed point values with one decimal
+ * instead of six full FGameplayAttributeData (base + current value each).
+ */
+USTRUCT()
+struct FPackedVitalAttributes
 {
 	GENERATED_BODY()
 
-	FGameplayEffectContextDetails()
+	float Health = 0.f;
+	float MaxHealth = 0.f;
+	float Mana = 0.f;
+	float MaxMana = 0.f;
+	float Stamina = 0.f;
+	float MaxStamina = 0.f;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FPackedVitalAttributes& Other) const;
+	bool operator!=(const FPackedVitalAttributes& Other) const { return !(*this == Other); }
+};
+
+template<>
+struct TStructOpsTypeTraits<FPackedVitalAttributes> : public TStructOpsTypeTraitsBase2<FPackedVitalAttributes>
+{
+	enum
 	{
-		SourceProperties = MakeShared<FGameplayEffectContextInfo>();
-		TargetProperties = MakeShared<FGameplayEffectContextInfo>();
-	}
-    
-	TSharedPtr<FGameplayEffectContextHandle> GameplayEffectContextHandle;
-    
-	TSharedPtr<FGameplayEffectContextInfo> SourceProperties;
- 
-	TSharedPtr<FGameplayEffectContextInfo> TargetProperties;
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
 };
 
 /**
@@ -113,6 +157,9 @@ public:
 	 *	It is not called on effects with duration/infinite with no period like a buff/debuff.
 	 */
 	virtual void PostGameplayEffectExecute(const FGameplayEffectModCallbackData& Data) override;
+
+	// Server. Keeps ReplicatedVitals in sync with the vital attributes.
+	virtual void PostAttributeChange(const FGameplayAttribute& Attribute, float OldValue, float NewValue) override;
 	
 
 #pragma region Attributes
@@ -418,13 +465,23 @@ public:
 	UFUNCTION()
 	void OnRep_MaxStamina(const FGameplayAttributeData& OldMaxStamina) const;
 #pragma endregion
+
+	// Unpacks the vitals into their attributes and runs their regular OnRep functions.
+	UFUNCTION()
+	void OnRep_ReplicatedVitals();
 #pragma endregion
 	
 private:
 
-	/**
-	 * The function is responsible for setting up and populating the FGameplayEffectExecutionContext struct.
+	void ShowFloatingDamageText(FGameplayEffectContextDetails& GameplayEffectContextDetails, float Damage, bool bEvadedHit, bool bCriticalHit, bool bBlockChance) const;
+
+	// Writes a replicated vital value into its attribute and calls the attribute's OnRep function when it changed.
+	void ApplyReplicatedVital(FGameplayAttributeData& AttributeData, float NewValue, void (UBaseAttributeSet::*OnRepFunction)(const FGameplayAttributeData&) const);
+
+	/*
+	 * The full precision vital attributes only go to the owner, everyone else gets this.
+	 * Health bars of other players and enemies are driven from here.
 	 */
-	void InitializeEffectExecutionContext(const FGameplayEffectModCallbackData& Data, FGameplayEffectContextDetails& GameplayEffectContextDetails) const;
-	void ShowFloatingDamageText(const FGameplayEffectContextDetails& GameplayEffectContextDetails, float Damage, bool bEvadedHit, bool bCriticalHit, bool bBlockChance) const;
+	UPROPERTY(ReplicatedUsing=OnRep_ReplicatedVitals)
+	FPackedVitalAttributes ReplicatedVitals;
 };
@@ -47,7 +47,22 @@ public:
 	// We have a function we can call, and it's a public function that we can simply pass in a tag to and receive the attribute info.
 	FTopDownAttributeInfo FindAttributeInfoForTag(const FGameplayTag& AttributeTag, bool bLogNotFound = false) const;
 
+	// Index into AttributeInformation, INDEX_NONE if the tag has no info. A hash lookup, no copy.
+	int32 FindAttributeInfoIndex(const FGameplayTag& AttributeTag) const;
+
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 	// Attribute array list in Data Asset, filled in blueprint
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta=(TitleProperty="AttributeName"))
 	TArray<FTopDownAttributeInfo> AttributeInformation;
+
+private:
+
+	void BuildAttributeIndex();
+
+	// AttributeInformation index by tag, rebuilt on load and whenever the array is edited.
+	TMap<FGameplayTag, int32> AttributeIndexByTag;
 };
@@ -8,6 +8,7 @@
 
 class UGameplayAbility;
 class UGameplayEffect;
+class UCurveTable;
 
 UENUM(BlueprintType)
 enum class ECharacterClass : uint8 
@@ -17,6 +18,21 @@ enum class ECharacterClass : uint8
 	Sorcerer
 };
 
+/*
+ * Coefficients read from the DamageCalculationCoefficients curve table by the damage execution calculation.
+ * Each entry name must match a row name in the curve table. Adding a curve is just adding an entry here,
+ * it gets baked together with the others.
+ */
+UENUM(BlueprintType)
+enum class EDamageCoefficient : uint8
+{
+	ArmorPenetration,
+	EffectiveArmor,
+	CriticalHitResistance,
+
+	MAX UMETA(Hidden)
+};
+
 USTRUCT(BlueprintType)
 struct FCharacterClassDefaultInfo
 {
@@ -64,4 +80,40 @@ public:
 
 	UPROPERTY(EditDefaultsOnly, Category="Common Class Defaults|Curve Tables")
 	TObjectPtr<UCurveTable> DamageCalculationCoefficients;
+
+	// Highest character level baked into the damage coefficient lookup tables. Levels above it fall back to evaluating the curve.
+	UPROPERTY(EditDefaultsOnly, Category="Common Class Defaults|Curve Tables", meta=(ClampMin=1))
+	int32 MaxBakedCoefficientLevel = 100;
+
+	// O(1) lookup of a damage coefficient for a character level, read from the tables baked on load.
+	float GetDamageCoefficient(EDamageCoefficient Coefficient, int32 Level) const;
+
+	virtual void PostLoad() override;
+	virtual void BeginDestroy() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+
+	// Evaluates every EDamageCoefficient curve once per level and stores the results in BakedDamageCoefficients.
+	void BakeDamageCoefficients();
+
+	// Slow path, used for levels outside of the baked range.
+	float EvaluateDamageCoefficientCurve(EDamageCoefficient Coefficient, int32 Level) const;
+
+	/*
+	 * One level-indexed table per EDamageCoefficient entry.
+	 * Index 0 is level 0 so the character level can be used as the index directly.
+	 */
+	TArray<float> BakedDamageCoefficients[static_cast<uint8>(EDamageCoefficient::MAX)];
+
+#if WITH_EDITOR
+	// Re-bakes the tables when the curve table is edited or reimported in the editor.
+	void BindCurveTableChanged();
+	void UnbindCurveTableChanged();
+
+	TWeakObjectPtr<UCurveTable> BoundCurveTable;
+	FDelegateHandle CurveTableChangedHandle;
+#endif
 };
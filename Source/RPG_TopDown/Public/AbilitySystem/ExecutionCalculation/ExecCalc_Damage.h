@@ -6,6 +6,38 @@
 #include "GameplayEffectExecutionCalculation.h"
 #include "ExecCalc_Damage.generated.h"
 
+/* Forward Declaration */
+class UAbilitySystemComponent;
+
+// Source side inputs of the damage formula. Captured once per spec.
+struct FTopDownDamageSourceParams
+{
+	float Damage = 0.f;
+	float ArmorPenetration = 0.f;
+	float CriticalHitChance = 0.f;
+	float CriticalHitDamage = 0.f;
+	float ArmorPenetrationCoefficient = 0.f;
+};
+
+// Target side inputs of the damage formula. Kept flat so a batch of targets can be resolved from one contiguous array.
+struct FTopDownDamageTargetParams
+{
+	float Armor = 0.f;
+	float BlockChance = 0.f;
+	float CriticalHitResistance = 0.f;
+	float Evasion = 0.f;
+	float EffectiveArmorCoefficient = 0.f;
+	float CriticalHitResistanceCoefficient = 0.f;
+};
+
+struct FTopDownDamageResult
+{
+	float Damage = 0.f;
+	bool bEvaded = false;
+	bool bBlocked = false;
+	bool bCriticalHit = false;
+};
+
 /**
  * 
  */
@@ -19,4 +51,15 @@ public:
 	UExecCalc_Damage();
 
 	virtual void Execute_Implementation(const FGameplayEffectCustomExecutionParameters& ExecutionParams, FGameplayEffectCustomExecutionOutput& OutExecutionOutput) const override;
+
+	// The damage formula itself: evasion, armor, block and critical hit. Shared with the batched damage path in UTopDownAbilitySystemLibrary.
+	static FTopDownDamageResult ResolveDamage(const FTopDownDamageSourceParams& Source, const FTopDownDamageTargetParams& Target);
+
+	/*
+	 * Capture the attributes ResolveDamage needs the same way Execute does, for callers that resolve damage outside an execution.
+	 * The source side comes from the captures Spec took when it was made, the target side is captured from TargetAbilitySystemComponent.
+	 * Damage and the level coefficients are left to the caller.
+	 */
+	static void CaptureSourceAttributes(const FGameplayEffectSpec& Spec, const FAggregatorEvaluateParameters& EvaluationParameters, FTopDownDamageSourceParams& OutSource);
+	static void CaptureTargetAttributes(UAbilitySystemComponent* TargetAbilitySystemComponent, const FAggregatorEvaluateParameters& EvaluationParameters, FTopDownDamageTargetParams& OutTarget);
 };
@@ -87,4 +87,12 @@ public:
 
 	UFUNCTION(BlueprintCallable, Category="TopDownAbilitySystemLibrary|GameplayEffects")
 	static void SetIsBlockedHit(UPARAM(ref) FGameplayEffectContextHandle& GameplayEffectContextHandle, bool bInIsBlockedHit);
+
+	/*
+	 * Damages many targets with one damage spec, e.g. an AoE. Server only.
+	 * The source attributes are captured once, the mitigation of every target is resolved in one pass with UExecCalc_Damage::ResolveDamage
+	 * and the spec is then applied to each target carrying its resolved damage, so the damage execution calculation does not resolve it again per target.
+	 */
+	UFUNCTION(BlueprintCallable, Category="TopDownAbilitySystemLibrary|GameplayEffects")
+	static void ApplyDamageEffectSpecToTargets(const FGameplayEffectSpecHandle& DamageEffectSpecHandle, const TArray<AActor*>& TargetActors);
 };
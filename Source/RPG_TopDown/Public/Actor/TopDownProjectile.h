@@ -5,9 +5,31 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "GameplayEffectTypes.h"
+#include "Engine/NetSerialization.h"
 #include "TopDownProjectile.generated.h"
 
+// Replicated launch state of a projectile that is recycled by UTopDownProjectilePoolSubsystem instead of being destroyed.
+USTRUCT()
+struct FPooledProjectileState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	bool bPooled = false;
+
+	UPROPERTY()
+	bool bActive = false;
 
+	// Bumped on every launch so clients can tell two consecutive shots of the same actor apart.
+	UPROPERTY()
+	uint8 LaunchCount = 0;
+
+	UPROPERTY()
+	FVector_NetQuantize10 LaunchLocation = FVector::ZeroVector;
+
+	UPROPERTY()
+	FRotator LaunchRotation = FRotator::ZeroRotator;
+};
 
 /* Forward Declaration */
 class UProjectileMovementComponent;
@@ -30,12 +52,26 @@ public:
 	UPROPERTY(BlueprintReadWrite, meta=(ExposeOnSpawn = true))
 	FGameplayEffectSpecHandle DamageEffectSpecHandle;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/* Pooling, driven by UTopDownProjectilePoolSubsystem on the server */
+	// Must be called before FinishSpawning.
+	void MarkPooled() { PooledState.bPooled = true; }
+	bool IsPooled() const { return PooledState.bPooled; }
+	// Puts the projectile back into flight from LaunchTransform. DamageEffectSpecHandle must already be set.
+	void ActivatePooledProjectile(const FTransform& LaunchTransform);
+	// Takes the projectile out of play and clears everything the last shot left behind.
+	void DeactivatePooledProjectile();
+
 protected:
 	
 	virtual void BeginPlay() override;
 
 	virtual void Destroyed() override;
 
+	// Hands the projectile back to its pool, or destroys it if it did not come from one. Server only.
+	void EndProjectile();
+
 	UFUNCTION()
 	virtual void OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 		UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult);
@@ -65,4 +101,27 @@ private:
 	UPROPERTY(EditAnywhere, Category="Effects")
 	float LifeSpan = 2.5f;
 
+	// When above zero, every character within this radius of the impact is damaged in one batch instead of only the actor hit.
+	UPROPERTY(EditAnywhere, Category="Damage", meta=(ClampMin="0.0", Units="cm"))
+	float ImpactDamageRadius = 0.f;
+
+	// Impact sound, impact VFX and stopping the looping sound.
+	void PlayImpactEffects();
+
+	/* Pooling */
+	void StartFlight(const FVector& Location, const FRotator& Rotation);
+	void StopFlight();
+
+	UFUNCTION()
+	void OnRep_PooledState();
+
+	UPROPERTY(ReplicatedUsing=OnRep_PooledState)
+	FPooledProjectileState PooledState;
+
+	// The last PooledState.LaunchCount this machine started flying.
+	uint8 LocalLaunchCount = 0;
+
+	bool bInFlight = false;
+
+	FTimerHandle PooledLifeSpanTimerHandle;
 };
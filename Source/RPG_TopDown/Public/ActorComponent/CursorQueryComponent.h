@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "CursorQueryComponent.generated.h"
+
+/* Forward Declaration */
+class APlayerController;
+
+/*
+ * Answers "what is under the cursor" for the owning player controller.
+ * The cursor state (screen position + camera transform) is sampled at most once per frame and every query is cached against it,
+ * so highlighting, click to move and ability targeting share one trace per channel instead of tracing on their own.
+ * While neither the mouse nor the camera moves the cached hits are reused until MaxCacheAge runs out.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class RPG_TOPDOWN_API UCursorQueryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCursorQueryComponent();
+
+	// Finds the actor to highlight under the cursor. Returns false when nothing was hit and the current highlight should be kept.
+	// bUseSpatialGrid picks an actor of ActorClassFilter from UTopDownSpatialGridSubsystem, falling back to the trace without the subsystem.
+	// A pick is rejected when the visibility trace shows world geometry in front of it.
+	bool GetHighlightActor(AActor*& OutActor, bool bUseSpatialGrid, TSubclassOf<AActor> ActorClassFilter = nullptr);
+
+	// Cursor trace against ECC_Visibility, used for highlighting.
+	const FHitResult& GetVisibilityHit();
+
+	// Traces ECC_Visibility now, ignoring the cache, and stores the result for the rest of the frame. Used for ability target data.
+	const FHitResult& GetFreshVisibilityHit();
+
+	// Cursor trace against ECC_Navigation, used for click to move.
+	const FHitResult& GetNavigationHit();
+
+	/** Getter Functions */
+	uint32 GetTracesPerformed() const { return TracesPerformed; }
+	uint32 GetTracesAvoided() const { return TracesAvoided; }
+
+private:
+
+	// One cached query result, only valid for the cursor state it was made with.
+	struct FCursorQueryCache
+	{
+		FHitResult HitResult;
+		bool bUpToDate = false;
+	};
+
+	// Samples the cursor state once per frame and drops the cached queries when it changed or got too old.
+	void UpdateCursorState();
+	void InvalidateQueries();
+
+	const FHitResult& GetCachedHit(FCursorQueryCache& Cache, ECollisionChannel TraceChannel);
+	const FHitResult& TraceIntoCache(FCursorQueryCache& Cache, ECollisionChannel TraceChannel);
+
+	APlayerController* GetPlayerController() const;
+
+	/* Cursor State */
+	FVector2D MousePosition = FVector2D::ZeroVector;
+	FVector CameraLocation = FVector::ZeroVector;
+	FRotator CameraRotation = FRotator::ZeroRotator;
+	bool bHasMousePosition = false;
+	uint64 LastUpdateFrame = 0;
+	double LastQueryTime = 0.0;
+
+	/* Cached Queries */
+	FCursorQueryCache VisibilityQuery;
+	FCursorQueryCache NavigationQuery;
+	TWeakObjectPtr<AActor> PickedActor;
+	bool bPickedActorUpToDate = false;
+
+	/* Stats */
+	uint32 TracesPerformed = 0;
+	uint32 TracesAvoided = 0;
+
+	// Cached hits are refreshed after this long even if the cursor did not move, so actors walking under a still cursor are picked up.
+	UPROPERTY(EditDefaultsOnly, Category="Cursor", meta=(ClampMin=0.f, Units="s"))
+	float MaxCacheAge = 0.1f;
+
+	// Camera movement below these is treated as no movement.
+	UPROPERTY(EditDefaultsOnly, Category="Cursor", meta=(ClampMin=0.f))
+	float CameraLocationTolerance = 0.1f;
+	UPROPERTY(EditDefaultsOnly, Category="Cursor", meta=(ClampMin=0.f))
+	float CameraRotationTolerance = 0.01f;
+};
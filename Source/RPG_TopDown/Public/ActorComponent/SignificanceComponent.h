@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SignificanceComponent.generated.h"
+
+UENUM(BlueprintType)
+enum class ESignificanceTier : uint8
+{
+	High,
+	Medium,
+	Low,
+	Lowest
+};
+
+// What the owner is allowed to spend while it is in a tier.
+USTRUCT(BlueprintType)
+struct FSignificanceTierSettings
+{
+	GENERATED_BODY()
+
+	// Effective screen distance this tier starts at. Ignored for High.
+	UPROPERTY(EditAnywhere, Category="Significance", meta=(ClampMin=0.f, Units="cm"))
+	float MinDistance = 0.f;
+
+	// 0 ticks every frame.
+	UPROPERTY(EditAnywhere, Category="Significance", meta=(ClampMin=0.f, Units="s"))
+	float AnimationTickInterval = 0.f;
+
+	UPROPERTY(EditAnywhere, Category="Significance", meta=(ClampMin=0.f, Units="s"))
+	float MovementTickInterval = 0.f;
+
+	UPROPERTY(EditAnywhere, Category="Significance")
+	bool bShowWidgets = true;
+
+	// 0 redraws the widgets every frame.
+	UPROPERTY(EditAnywhere, Category="Significance", meta=(ClampMin=0.f, Units="s"))
+	float WidgetRedrawTime = 0.f;
+};
+
+/*
+ * Registers the owning character with the significance manager and budgets its animation, movement and widget ticks by tier.
+ * Significance is the distance from the camera's view axis, so roughly the distance from the middle of the screen,
+ * halved while the owner is in combat (recently hit or under the cursor). Tier changes use a hysteresis band so enemies
+ * standing on a tier boundary don't flip every frame. Only runs where there is a local player, the local player controller
+ * drives the significance manager from its PlayerTick.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class RPG_TOPDOWN_API USignificanceComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USignificanceComponent();
+
+	// Keeps the owner combat relevant for CombatRelevanceTime seconds.
+	void NotifyCombatActivity();
+
+	ESignificanceTier GetSignificanceTier() const { return SignificanceTier; }
+
+	// Updates the significance manager with the view of the local player. Call once per frame.
+	static void UpdateSignificance(const UWorld* World, const FTransform& ViewTransform);
+
+protected:
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+
+	// Called by the significance manager, possibly off the game thread. Only touches this component.
+	float CalculateSignificance(const FTransform& ViewTransform);
+	void PostSignificanceUpdate();
+
+	void SetSignificanceTier(ESignificanceTier NewTier);
+	void ApplySignificanceTier() const;
+
+	bool IsCombatRelevant() const;
+
+	UPROPERTY(EditAnywhere, EditFixedSize, Category="Significance")
+	TArray<FSignificanceTierSettings> TierSettings;
+
+	// How far past a tier boundary the owner has to move before the tier changes.
+	UPROPERTY(EditAnywhere, Category="Significance", meta=(ClampMin=0.f, Units="cm"))
+	float HysteresisDistance = 200.f;
+
+	UPROPERTY(EditAnywhere, Category="Significance", meta=(ClampMin=0.f, Units="s"))
+	float CombatRelevanceTime = 3.f;
+
+	// Effective distance is scaled by this while combat relevant.
+	UPROPERTY(EditAnywhere, Category="Significance", meta=(ClampMin=0.f, ClampMax=1.f))
+	float CombatDistanceScale = 0.5f;
+
+	ESignificanceTier SignificanceTier = ESignificanceTier::High;
+	float EffectiveDistance = 0.f;
+	double LastCombatActivityTime = -UE_BIG_NUMBER;
+	bool bRegistered = false;
+};
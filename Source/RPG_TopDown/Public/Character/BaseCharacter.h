@@ -49,7 +49,15 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void InitAbilityActorInfo();
+
+	/*
+	 * Spatial Grid
+	 */
+	// Makes the character show up in radius, cone and cursor pick queries of UTopDownSpatialGridSubsystem.
+	void RegisterWithSpatialGrid();
+	void UnregisterFromSpatialGrid();
 	
 	/*
 	 * Common Variables
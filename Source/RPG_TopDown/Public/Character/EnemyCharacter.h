@@ -7,10 +7,13 @@
 #include "Character/BaseCharacter.h"
 #include "Interface/Interaction/HighlightActorInterface.h"
 #include "Controller/Widget/OverlayWidgetController.h"
+#include "Subsystem/TopDownAttributeStoreSubsystem.h"
 #include "EnemyCharacter.generated.h"
 
 /* Forward Declaration */
 class UWidgetComponent;
+class USignificanceComponent;
+class UStaticMesh;
 
 /**
  * 
@@ -24,6 +27,9 @@ public:
 	
 	AEnemyCharacter();
 
+	// Sets level and class on an enemy spawned deferred, before FinishSpawning applies the default attributes.
+	void InitializeSpawnDefaults(int32 InLevel, ECharacterClass InCharacterClass);
+
 	/* Delegate Signature from Overlay Widget Controller */
 	UPROPERTY(BlueprintAssignable)
 	FOnAttributeChangedSignature OnHealthChanged;
@@ -48,10 +54,15 @@ public:
 	float BaseWalkSpeed = 250.f;
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Combat")
 	float LifeSpan = 5.f;
+
+	/* Getter Functions */
+	UStaticMesh* GetCrowdProxyMesh() const { return CrowdProxyMesh; }
+	const FTransform& GetCrowdProxyTransform() const { return CrowdProxyTransform; }
 	
 protected:
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 
 	/* Game Ability System */
@@ -77,4 +88,35 @@ protected:
 	/* Widget Component */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	TObjectPtr<UWidgetComponent> HealthBar;
+
+	// Draw the health bar through the HUD's shared health bar pass instead of the HealthBar widget component, which is then removed.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Widget|Health Bar")
+	bool bUseSharedHealthBar = true;
+
+	// Height above the actor location the shared health bar is drawn at.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Widget|Health Bar", meta=(EditCondition="bUseSharedHealthBar", Units="cm"))
+	float SharedHealthBarHeight = 120.f;
+
+	/* Crowd LOD */
+	void RegisterWithCrowd();
+	void UnregisterFromCrowd();
+
+	// Whether the enemy may be demoted to a crowd entity while far from every player. It comes back from class defaults,
+	// so only turn this on for enemies without per instance edits or AI state worth keeping.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Crowd")
+	bool bCanDemoteToCrowd = false;
+
+	// Instanced stand in drawn while the enemy is a crowd entity. Nothing is drawn when unset.
+	UPROPERTY(EditDefaultsOnly, Category="Crowd")
+	TObjectPtr<UStaticMesh> CrowdProxyMesh;
+
+	// Proxy mesh transform relative to the actor, the actor location is the middle of the capsule.
+	UPROPERTY(EditDefaultsOnly, Category="Crowd")
+	FTransform CrowdProxyTransform;
+
+	// Slot in the world attribute store, unset while the store is disabled.
+	FTopDownAttributeHandle AttributeStoreHandle;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	TObjectPtr<USignificanceComponent> Significance;
 };
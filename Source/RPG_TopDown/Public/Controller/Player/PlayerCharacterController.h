@@ -6,6 +6,8 @@
 #include "InputActionValue.h"
 #include "GameFramework/PlayerController.h"
 #include "GameplayTagContainer.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "Controller/Player/TopDownPathFollower.h"
 #include "PlayerCharacterController.generated.h"
 
 
@@ -18,8 +20,31 @@ class UTopDownInputConfigDataAsset;
 class UBaseAbilitySystemComponent;
 class USplineComponent;
 class UDamageTextWidgetComponent;
+class UCursorQueryComponent;
 struct FInputActionValue;
 
+// One floating damage number, as sent to the owning client.
+USTRUCT()
+struct FDamageNumberEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<ACharacter> TargetCharacter = nullptr;
+
+	UPROPERTY()
+	float DamageAmount = 0.f;
+
+	UPROPERTY()
+	bool bEvadedHit = false;
+
+	UPROPERTY()
+	bool bCriticalHit = false;
+
+	UPROPERTY()
+	bool bBlockChance = false;
+};
+
 /**
  * APlayerCharacterController
  * This class manages player input and activates abilities based on input actions and gameplay tags.
@@ -35,9 +60,15 @@ public:
 
 	virtual void PlayerTick(float DeltaTime) override;
 
+	// Server. Queues a damage number for this controller's client, everything queued in one frame goes out in a single RPC.
+	void ShowDamageNumber(float DamageAmount, ACharacter* TargetCharacter, bool bEvadedHit, bool bCriticalHit, bool bBlockChance);
+
 	// Client RPC
 	UFUNCTION(Client, Reliable)
-	void ShowDamageNumber(float DamageAmount, ACharacter* TargetCharacter, bool bEvadedHit, bool bCriticalHit, bool bBlockChance);
+	void ClientShowDamageNumbers(const TArray<FDamageNumberEntry>& DamageNumbers);
+
+	// Gives a damage text component back to the pool once it is done showing.
+	void ReleaseDamageText(UDamageTextWidgetComponent* DamageText);
 
 protected:
 	
@@ -75,6 +106,13 @@ private:
 	
 	/* Mouse Cursor */
 	void CursorTrace();
+	// Finds the actor under the cursor. Returns false when nothing was hit and the current highlight should be kept.
+	bool TraceActorUnderCursor(AActor*& OutActor) const;
+	// Pick the highlighted enemy from UTopDownSpatialGridSubsystem instead of a physics trace. Still needs the visibility trace to reject occluded picks.
+	UPROPERTY(EditDefaultsOnly, Category="Input|Cursor")
+	bool bUseSpatialGridCursorPick = false;
+	UPROPERTY(VisibleAnywhere)
+	TObjectPtr<UCursorQueryComponent> CursorQuery;
 	void SetCursorSettings();
 	TScriptInterface<IHighlightActorInterface> LastActor;
 	TScriptInterface<IHighlightActorInterface> ThisActor;
@@ -89,15 +127,40 @@ private:
 	UPROPERTY(EditDefaultsOnly, Category="References|Classes")
 	TSubclassOf<UDamageTextWidgetComponent> DamageTextWidgetComponentClass;
 
+	/* Damage Numbers */
+	void FlushDamageNumbers();
+	void RenderDamageNumber(const FDamageNumberEntry& DamageNumber);
+	UDamageTextWidgetComponent* AcquireDamageText(ACharacter* TargetCharacter);
+	TArray<FDamageNumberEntry> PendingDamageNumbers;
+	UPROPERTY()
+	TArray<TObjectPtr<UDamageTextWidgetComponent>> DamageTextPool;
+	// Hits on the same target within one frame are shown as one number.
+	UPROPERTY(EditDefaultsOnly, Category="Damage Numbers")
+	bool bMergeDamageNumbersPerTarget = true;
+	UPROPERTY(EditDefaultsOnly, Category="Damage Numbers")
+	int32 MaxPooledDamageTexts = 32;
+
 	/* Character Movement */
 	void AutoRun();
+	// Starts an async path query to CachedMoveDestination, replacing any query that is still pending.
+	void RequestMovePath();
+	void AbortMovePathQuery();
+	void OnMovePathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr NavigationPath);
+	uint32 PendingMovePathQueryId = INVALID_NAVQUERYID;
 	FVector CachedMoveDestination = FVector::ZeroVector;
+	// Steers along the path being auto run, CachedMoveDestination already follows the cursor again while a new path is pending.
+	FTopDownPathFollower PathFollower;
 	float FollowTime = 0.f;
 	float ShortPressThreshold = 0.5f;
 	bool bAutoRunning = false;
 	bool bTargeting = false;
 	UPROPERTY(EditDefaultsOnly,	Category="Character Movement|Click And Move")
 	float AutoRunAcceptanceRadius = 25.f;
+	UPROPERTY(EditDefaultsOnly,	Category="Character Movement|Click And Move")
+	float AutoRunLookAheadDistance = 100.f;
+	UPROPERTY(EditDefaultsOnly,	Category="Character Movement|Click And Move")
+	float AutoRunCornerTrimRadius = 50.f;
+	// Only used to visualize the path, movement follows PathFollower.
 	UPROPERTY(VisibleAnywhere)
 	TObjectPtr<USplineComponent> Spline;
 	
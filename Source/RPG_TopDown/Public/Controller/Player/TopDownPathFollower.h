@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * FTopDownPathFollower
+ * Steers along a polyline path (navigation path points) for click to move.
+ * It remembers the segment it is on and only ever moves forward, so each update looks at the current segment
+ * and the few after it instead of searching the whole path. Distances are measured on the XY plane,
+ * the pawn's capsule center sits above the navmesh points.
+ */
+struct RPG_TOPDOWN_API FTopDownPathFollower
+{
+	// Takes over a new path and starts following it from its first segment.
+	void SetPath(const TArray<FVector>& InPathPoints);
+
+	// Advances along the path for the pawn location and returns the direction to move in. Returns false once the end is reached.
+	bool Update(const FVector& Location, FVector& OutDirection);
+
+	// Distance to the path end at which we count as arrived.
+	float AcceptanceRadius = 25.f;
+	// How far ahead of our projected position on the path we steer towards. Smooths out the turns.
+	float LookAheadDistance = 100.f;
+	// A corner counts as passed once we are this close to it, so we do not have to run all the way into it.
+	float CornerTrimRadius = 50.f;
+
+private:
+
+	int32 GetLastSegmentIndex() const { return PathPoints.Num() - 2; }
+
+	// Walks Distance forward along the path from the current segment position.
+	FVector GetPointAhead(float Distance) const;
+
+	TArray<FVector> PathPoints;
+	// Segment from PathPoints[SegmentIndex] to PathPoints[SegmentIndex + 1].
+	int32 SegmentIndex = 0;
+	// 0..1 along the current segment, never goes back.
+	float SegmentAlpha = 0.f;
+};
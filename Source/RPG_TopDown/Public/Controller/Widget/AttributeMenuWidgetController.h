@@ -15,6 +15,8 @@ struct FTopDownAttributeInfo;
 // Dynamic multicast delegates for broadcasting attribute changes.
 // This delegate is used to notify UI elements of changes in attributes.
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FAttributeInfoSignature, const FTopDownAttributeInfo&, Info);
+// Every attribute that changed since the last update, sent once per frame at most.
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FAttributeInfoBatchSignature, const TArray<FTopDownAttributeInfo>&, Infos);
 
 /**
  * The UAttributeMenuWidgetController class is responsible for managing and updating the UI elements related to character attributes in the game.
@@ -45,6 +47,10 @@ public:
 	UPROPERTY(BlueprintAssignable, Category="GAS|Attributes")
 	FAttributeInfoSignature AttributeInfoDelegate;
 
+	// Same updates as AttributeInfoDelegate, collected into one call per frame.
+	UPROPERTY(BlueprintAssignable, Category="GAS|Attributes")
+	FAttributeInfoBatchSignature AttributeInfoBatchDelegate;
+
 
 protected:
 
@@ -52,9 +58,19 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category="GAS|Data Asset")
 	TObjectPtr<UAttributeInfoDataAsset> AttributeInfoDataAsset;
 
+	// Broadcasts every attribute that changed value since it was last broadcast.
+	virtual void FlushPendingBroadcasts() override;
+
 private:
 
-	// Helper function to broadcast attribute info to UI elements.
-	void BroadcastAttributeInfo(const UAttributeSet* AS, const FTopDownAttributeInfo& Tag) const;
+	// Helper function to broadcast attribute info to UI elements. Skips the broadcast if the value hasn't changed, unless forced.
+	bool BroadcastAttributeInfo(int32 AttributeIndex, bool bForce, TArray<FTopDownAttributeInfo>* OutBatch = nullptr);
+
+	// Sizes LastBroadcastValues and PendingAttributes to the data asset.
+	void InitializeAttributeTracking();
+
+	// Indexed like AttributeInfoDataAsset->AttributeInformation.
+	TArray<float> LastBroadcastValues;
+	TBitArray<> PendingAttributes;
 };
 
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "AttributeSet.h"
+#include "Engine/TimerHandle.h"
 #include "UObject/NoExportTypes.h"
 #include "BaseWidgetController.generated.h"
 
@@ -85,5 +86,24 @@ protected:
 
 	UPROPERTY(BlueprintReadOnly, Category="Main Data Classes")
 	TObjectPtr<UAttributeSet> AttributeSet;
+
+	/** Batched Broadcasts */
+
+	// Calls FlushPendingBroadcasts once on the next tick, however many times it is requested this frame.
+	void RequestFlushNextTick();
+
+	// Same, but leaves at least MinInterval seconds between flushes. 0 flushes on the next tick.
+	void RequestFlush(float MinInterval);
+
+	// Override to broadcast whatever changed since the last flush.
+	virtual void FlushPendingBroadcasts();
+
+private:
+
+	void OnFlushTimer();
+
+	bool bFlushRequested = false;
+	double LastFlushTime = -UE_BIG_NUMBER;
+	FTimerHandle FlushTimerHandle;
 	
 };
@@ -49,6 +49,33 @@ struct FGameplayTagMessageInfoRow : public FTableRowBase
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAttributeChangedSignature, float, NewValue);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FGameplayTagMessageInfoRowSignature, const FGameplayTagMessageInfoRow&, GameplayTagMessageInfoRow);
 
+// All six vitals in one struct, for widgets that want a single update per frame.
+USTRUCT(BlueprintType)
+struct FOverlayVitalAttributes
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	float Health = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float MaxHealth = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float Mana = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float MaxMana = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float Stamina = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float MaxStamina = 0.f;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnVitalAttributesChangedSignature, const FOverlayVitalAttributes&, VitalAttributes);
+
 /**
  * UOverlayWidgetController is responsible for managing the UI overlay widget,
  * handling attribute changes, and broadcasting these changes to Blueprint.
@@ -93,6 +120,14 @@ public:
 	UPROPERTY(BlueprintAssignable, Category="GAS|Attributes")
 	FOnAttributeChangedSignature OnMaxStaminaChanged;
 
+	// The vitals after this frame's changes, sent once per flush alongside the individual delegates above.
+	UPROPERTY(BlueprintAssignable, Category="GAS|Attributes")
+	FOnVitalAttributesChangedSignature OnVitalAttributesChanged;
+
+	// Vital changes that were folded into an already pending update instead of being broadcast.
+	UFUNCTION(BlueprintPure, Category="GAS|Attributes")
+	int32 GetNumSuppressedVitalBroadcasts() const { return NumSuppressedVitalBroadcasts; }
+
 	// Bind in WBP_Overlay 
 	UPROPERTY(BlueprintAssignable, Category="GAS|Messages")
 	FGameplayTagMessageInfoRowSignature GameplayTagMessageInfoRowDelegate;
@@ -106,12 +141,43 @@ protected:
 	template<typename T>
 	T* GetDataTableRowByTag(UDataTable* DataTable, const FGameplayTag& GameplayTag);
 
+	// Broadcasts the vitals that changed since the last flush.
+	virtual void FlushPendingBroadcasts() override;
+
 private:
 	
 	// Function to bind attribute change callbacks to the Ability System Component
 	void BindVitalAttributeChangeCallbacks(const UBaseAttributeSet* BaseAttributeSet);
+
+	// Which vital a pending value belongs to, also its bit in DirtyVitals.
+	enum class EVitalAttribute : uint8
+	{
+		Health,
+		MaxHealth,
+		Mana,
+		MaxMana,
+		Stamina,
+		MaxStamina,
+		Num
+	};
+
+	// Records the new value and schedules a flush. Nothing is broadcast until then.
+	void MarkVitalDirty(EVitalAttribute Vital, float NewValue);
+
+	FOverlayVitalAttributes PendingVitals;
+	uint8 DirtyVitals = 0;
+	int32 NumSuppressedVitalBroadcasts = 0;
 	// Function to bind GameplayEffectAssetTags to a lambda function
 	void BindGameplayEffectTagMessages();
+
+	// Fills MessageRowsByTag from GameplayTagToUIMessageDataTable, so applied effects don't look rows up by name.
+	void BuildMessageRowCache();
+
+	// Rows of GameplayTagToUIMessageDataTable by the tag their row name is. Points into the table, which the UPROPERTY keeps alive.
+	TMap<FGameplayTag, const FGameplayTagMessageInfoRow*> MessageRowsByTag;
+
+	// "Message", the parent of every message tag.
+	FGameplayTag MessageParentTag;
 };
 
 /*
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "TopDownReplicationGraph.generated.h"
+
+/* Forward Declaration */
+class UReplicationGraphNode_GridSpatialization2D;
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_PlayerStateFrequencyLimiter;
+
+// Which node a replicated class is routed to.
+enum class ETopDownClassNodeMapping : uint8
+{
+	// Not added to any node. Player controllers come in through the owner node as viewers.
+	NotRouted,
+	// bOnlyRelevantToOwner actors, added to the owner node of their net owner's connection.
+	OwnerRelevant,
+	// Replicated to every connection, e.g. the game state.
+	RelevantAllConnections,
+	// Other players' player states, throttled by the player state frequency limiter.
+	PlayerState,
+	// Spatialized and never moves.
+	SpatializeStatic,
+	// Spatialized and moves, gathered every frame. Enemies and player pawns.
+	SpatializeDynamic,
+	// Spatialized, treated as static while dormant. Pooled projectiles spend most of their life parked and dormant.
+	SpatializeDormancy
+};
+
+/**
+ * Per connection node for everything only the owning connection cares about: its player controller,
+ * its player state (with the ability system component on it), its view target and any other owner only actors it owns.
+ */
+UCLASS()
+class RPG_TOPDOWN_API UTopDownReplicationGraphNode_OwnerRelevant : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& Actor) override {}
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override {}
+
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	// Owner only actors whose net owner is this node's connection, kept up to date by UTopDownReplicationGraph.
+	void AddOwnedActor(AActor* Actor);
+	void RemoveOwnedActor(AActor* Actor);
+
+private:
+
+	FActorRepListRefView ReplicationActorList;
+	FActorRepListRefView OwnedActorList;
+};
+
+/**
+ * Replaces the default per connection relevancy loop on the server. Enemies, pawns and projectiles go into a 2D spatial grid,
+ * so each connection only looks at the cells around its view, and within a cell actors are put into per connection frequency
+ * buckets by distance (UReplicationGraphNode_DynamicSpatialFrequency). Own player state and controller always replicate
+ * to their owner, other players' states go through the player state frequency limiter.
+ * Enabled through ReplicationDriverClassName in DefaultEngine.ini.
+ */
+UCLASS(Transient)
+class RPG_TOPDOWN_API UTopDownReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual void RemoveClientConnection(UNetConnection* NetConnection) override;
+
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	// For actors that change their NetUpdateFrequency at runtime, the graph otherwise keeps the class rate.
+	// Updates the global settings, which new connections copy, and the actor's entry on every existing connection.
+	void SetActorNetUpdateFrequency(AActor* Actor, float NetUpdateFrequency);
+
+	// Logs the replication period the graph uses for Actor, globally and per connection. Read by TopDown.PlayerState.NetReport.
+	void LogActorReplicationPeriod(AActor* Actor);
+
+	/* Replication Timing, read by TopDown.RepGraph.Report */
+	void ResetReplicationTiming();
+	void LogReplicationTiming() const;
+
+private:
+
+	ETopDownClassNodeMapping GetMappingPolicy(const UClass* Class);
+	void InitClassReplicationInfo(FClassReplicationInfo& ClassInfo, const UClass* Class, bool bSpatialize) const;
+
+	// Moves an owner only actor to the owner node of its current net owner's connection, if that changed.
+	void UpdateOwnerRelevantActor(AActor* Actor, TWeakObjectPtr<UNetReplicationGraphConnection>& RoutedConnection);
+	UTopDownReplicationGraphNode_OwnerRelevant* FindOwnerRelevantNode(const UNetReplicationGraphConnection* ConnectionManager) const;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_PlayerStateFrequencyLimiter> PlayerStateNode;
+
+	// Filled lazily per concrete class, so blueprint subclasses get their own entry.
+	TMap<TObjectKey<UClass>, ETopDownClassNodeMapping> ClassMappingPolicies;
+
+	// Owner only actors and the connection whose owner node they were added to. Owners can change, so this is checked every frame.
+	TMap<TObjectKey<AActor>, TWeakObjectPtr<UNetReplicationGraphConnection>> OwnerRelevantActors;
+
+	// The owner node of every connection, the connection holds on to it.
+	TMap<TObjectKey<UNetReplicationGraphConnection>, TWeakObjectPtr<UTopDownReplicationGraphNode_OwnerRelevant>> OwnerRelevantNodes;
+
+	uint64 ReplicateActorsCycles = 0;
+	uint64 ReplicateActorsMaxCycles = 0;
+	uint32 ReplicateActorsFrames = 0;
+	uint64 ConnectionFrames = 0;
+	int32 MaxConnections = 0;
+};
@@ -24,6 +24,7 @@ public:
 	ATopDownPlayerState();
 
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 
 	/** Ability System Interface */
 	virtual UAbilitySystemComponent* GetAbilitySystemComponent() const override;
@@ -32,14 +33,34 @@ public:
 	/** Getters */
 	FORCEINLINE int32 GetPlayerLevel() const { return Level; }
 
+	/** Adaptive Net Update Frequency */
+	// Server only. Replicate at ActiveNetUpdateFrequency until nothing changed for IdleNetUpdateDelay seconds.
+	void MarkNetActivity();
+
+	// Times this player state was considered for replication, and how many more the active rate, capped at the server tick rate, would have made.
+	FORCEINLINE uint32 GetReplicationChecks() const { return ReplicationChecks; }
+	FORCEINLINE uint32 GetSkippedReplicationChecks() const { return SkippedReplicationChecks; }
+
 protected:
 
+	virtual void BeginPlay() override;
+
 	/** Game Ability System */
 	UPROPERTY()
 	TObjectPtr<UAbilitySystemComponent> AbilitySystemComponent;
 	UPROPERTY()
 	TObjectPtr<UAttributeSet> AttributeSet;
 
+	UPROPERTY(EditDefaultsOnly, Category="Replication", meta=(ClampMin=1))
+	float ActiveNetUpdateFrequency = 100.f;
+
+	UPROPERTY(EditDefaultsOnly, Category="Replication", meta=(ClampMin=1))
+	float IdleNetUpdateFrequency = 2.f;
+
+	// Seconds without attribute, effect or ability changes before dropping to IdleNetUpdateFrequency.
+	UPROPERTY(EditDefaultsOnly, Category="Replication", meta=(ClampMin=0))
+	float IdleNetUpdateDelay = 1.5f;
+
 private:
 
 	// Character Level
@@ -48,4 +69,14 @@ private:
 
 	UFUNCTION()
 	void OnRep_Level(int32 OldLevel);
+
+	void CheckNetIdle();
+	void ApplyNetUpdateFrequency(float NewNetUpdateFrequency);
+
+	FTimerHandle NetIdleTimerHandle;
+	double LastNetActivityTime = 0.0;
+	double LastReplicationCheckTime = 0.0;
+	uint32 ReplicationChecks = 0;
+	uint32 SkippedReplicationChecks = 0;
+	bool bNetActive = false;
 };
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AttributeSet.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "TopDownAttributeStoreSubsystem.generated.h"
+
+/* Forward Declaration */
+class UAbilitySystemComponent;
+
+// Attributes mirrored into the store, one contiguous array each.
+enum class ETopDownStoredAttribute : uint8
+{
+	Health,
+	MaxHealth,
+	Armor,
+	MagicResistance,
+	Evasion,
+	BlockChance,
+	CriticalHitResistance,
+	Num
+};
+
+// Stable reference to a slot in the store. Goes stale once the slot is released, even if the slot is reused.
+struct FTopDownAttributeHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Generation = 0;
+
+	bool IsSet() const { return Index != INDEX_NONE; }
+	void Reset() { Index = INDEX_NONE; Generation = 0; }
+};
+
+/*
+ * Structure of arrays storage for the stored attributes, slots are recycled through a free list.
+ * Released slots keep their last values and read as dead, so iterate with IsSlotAlive or through ForEachAlive.
+ */
+struct RPG_TOPDOWN_API FTopDownAttributeStore
+{
+	FTopDownAttributeHandle Allocate();
+	void Release(const FTopDownAttributeHandle& Handle);
+
+	bool IsValid(const FTopDownAttributeHandle& Handle) const
+	{
+		return Generations.IsValidIndex(Handle.Index) && Generations[Handle.Index] == Handle.Generation && AliveSlots[Handle.Index];
+	}
+	bool IsSlotAlive(int32 Index) const { return AliveSlots[Index]; }
+
+	float GetValue(const FTopDownAttributeHandle& Handle, ETopDownStoredAttribute Attribute) const { return Values[static_cast<int32>(Attribute)][Handle.Index]; }
+	void SetValue(const FTopDownAttributeHandle& Handle, ETopDownStoredAttribute Attribute, float Value) { Values[static_cast<int32>(Attribute)][Handle.Index] = Value; }
+
+	// Raw per attribute array, indexed by slot. Includes dead slots.
+	TConstArrayView<float> GetValues(ETopDownStoredAttribute Attribute) const { return Values[static_cast<int32>(Attribute)]; }
+
+	int32 GetNumSlots() const { return Generations.Num(); }
+	int32 GetNumAlive() const { return GetNumSlots() - FreeSlots.Num(); }
+
+	template<typename FunctorType>
+	void ForEachAlive(FunctorType&& Visitor) const
+	{
+		for (TConstSetBitIterator<> It(AliveSlots); It; ++It)
+		{
+			Visitor(It.GetIndex());
+		}
+	}
+
+	void Reserve(int32 NumSlots);
+
+private:
+
+	TArray<float> Values[static_cast<int32>(ETopDownStoredAttribute::Num)];
+	TArray<uint32> Generations;
+	TBitArray<> AliveSlots;
+	TArray<int32> FreeSlots;
+};
+
+/**
+ * World level mirror of the hot combat attributes of every registered ability system component, so systems that walk all
+ * enemies (AoE resolution, regen, UI) read a few contiguous float arrays instead of one attribute set per enemy.
+ * The attribute set stays the source of truth, the store is filled on registration and kept coherent through the
+ * ability system's attribute change delegates. Opt in with TopDown.AttributeStore.Enabled.
+ */
+UCLASS()
+class RPG_TOPDOWN_API UTopDownAttributeStoreSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	static UTopDownAttributeStoreSubsystem* Get(const UObject* WorldContextObject);
+
+	static FGameplayAttribute GetGameplayAttribute(ETopDownStoredAttribute Attribute);
+
+	/* Registration */
+	// Returns an unset handle while the store is disabled.
+	FTopDownAttributeHandle Register(UAbilitySystemComponent* AbilitySystemComponent);
+	void Unregister(FTopDownAttributeHandle& Handle);
+
+	// Unset if the component isn't registered.
+	FTopDownAttributeHandle FindHandle(const UAbilitySystemComponent* AbilitySystemComponent) const;
+
+	const FTopDownAttributeStore& GetStore() const { return Store; }
+
+	virtual void Deinitialize() override;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	// Per slot bookkeeping, kept out of the hot arrays.
+	struct FRegisteredAbilitySystem
+	{
+		TWeakObjectPtr<UAbilitySystemComponent> AbilitySystemComponent;
+		// Still valid after the component is gone, so its entry in Handles can be removed.
+		TObjectKey<UAbilitySystemComponent> AbilitySystemComponentKey;
+		FDelegateHandle ChangeDelegateHandles[static_cast<int32>(ETopDownStoredAttribute::Num)];
+	};
+
+	void UnbindAttributeChanges(FRegisteredAbilitySystem& Registered) const;
+
+	FTopDownAttributeStore Store;
+	TArray<FRegisteredAbilitySystem> RegisteredAbilitySystems;
+	TMap<TObjectKey<UAbilitySystemComponent>, FTopDownAttributeHandle> Handles;
+};
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include <atomic>
+#include "TopDownCombatLogSubsystem.generated.h"
+
+enum class ETopDownCombatEventType : uint8
+{
+	// UExecCalc_Damage (or the batched damage path) resolved a hit.
+	DamageResolved,
+	// UBaseAttributeSet applied the resolved damage to Health.
+	DamageApplied
+};
+
+namespace ETopDownCombatEventFlags
+{
+	enum Type : uint8
+	{
+		None		= 0,
+		Evaded		= 1 << 0,
+		Blocked		= 1 << 1,
+		CriticalHit	= 1 << 2,
+		Fatal		= 1 << 3
+	};
+}
+
+/*
+ * One combat event, written to the combat log file as is. Keep it plain data and bump
+ * UTopDownCombatLogSubsystem's file version when the layout changes.
+ * Slots are zeroed before an event is written, so padding never carries stale memory into the file.
+ */
+struct FTopDownCombatEvent
+{
+	// Seconds since the world started.
+	double WorldTime = 0.0;
+	uint64 Frame = 0;
+	// Actor names taken when the event is recorded, as FName display entry and number. The name table is never
+	// trimmed, so they still resolve at flush time even after the actor is gone. The file maps them back to strings.
+	uint32 SourceNameIndex = 0;
+	uint32 SourceNameNumber = 0;
+	uint32 TargetNameIndex = 0;
+	uint32 TargetNameNumber = 0;
+	// Damage before and after armor, block and critical hits.
+	float RawDamage = 0.f;
+	float MitigatedDamage = 0.f;
+	ETopDownCombatEventType Type = ETopDownCombatEventType::DamageResolved;
+	// ETopDownCombatEventFlags
+	uint8 Flags = ETopDownCombatEventFlags::None;
+};
+
+/**
+ * Keeps the last few thousand combat events in a fixed size lock-free ring buffer, so balance and lag reports can be
+ * looked at after the fact without verbose logging. Recording is on by default and costs one slot write per event.
+ * TopDown.CombatLog.Flush writes the buffered events to Saved/CombatLogs for offline analysis.
+ */
+UCLASS()
+class RPG_TOPDOWN_API UTopDownCombatLogSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	static UTopDownCombatLogSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Fills in the time stamps. Lock-free, writers never wait on each other or on a flush in progress.
+	void RecordDamage(ETopDownCombatEventType Type, const AActor* SourceActor, const AActor* TargetActor, float RawDamage, float MitigatedDamage, uint8 Flags);
+
+	// Copies the buffered events out, oldest first. Events overwritten while copying are skipped.
+	void GetEvents(TArray<FTopDownCombatEvent>& OutEvents) const;
+
+	// Writes the buffered events and a name table for their actors to FilePath. Returns false if the file could not be written.
+	bool FlushToFile(const FString& FilePath) const;
+
+	static bool IsRecordingEnabled();
+
+	static uint8 MakeDamageFlags(bool bEvaded, bool bBlocked, bool bCriticalHit, bool bFatal = false);
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	struct FCombatEventSlot
+	{
+		FTopDownCombatEvent Event;
+		// Write index + 1 of the event in the slot, 0 while it is being written.
+		std::atomic<uint64> Sequence{0};
+	};
+
+	TUniquePtr<FCombatEventSlot[]> Slots;
+	uint64 SlotMask = 0;
+	std::atomic<uint64> WriteIndex{0};
+};
@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TopDownCombatSimulationSubsystem.generated.h"
+
+/* Forward Declaration */
+class ABaseEffectActor;
+class AEnemyCharacter;
+class APlayerCharacter;
+class UGameplayEffect;
+class UTopDownProjectileAbility;
+
+/*
+ * Times the damage resolution hot path (UExecCalc_Damage and the batched damage path) for the combat simulation.
+ * Game thread only, the scope macro is compiled out in Shipping. Outside a simulation it only checks bSimulationActive.
+ */
+struct RPG_TOPDOWN_API FTopDownCombatSimulationTimer
+{
+	FTopDownCombatSimulationTimer() : bTiming(bSimulationActive), StartCycles(bTiming ? FPlatformTime::Cycles64() : 0) {}
+	~FTopDownCombatSimulationTimer()
+	{
+		if (!bTiming) return;
+		ExecCalcCycles += FPlatformTime::Cycles64() - StartCycles;
+		++ExecCalcCount;
+	}
+
+	// Set by UTopDownCombatSimulationSubsystem while a simulation runs.
+	static bool bSimulationActive;
+	static uint64 ExecCalcCycles;
+	static uint32 ExecCalcCount;
+
+private:
+
+	bool bTiming;
+	uint64 StartCycles;
+};
+
+/*
+ * What UBaseAttributeSet::PostGameplayEffectExecute did since the last simulated frame. Game thread only, compiled out in Shipping.
+ * ContextAllocationsAvoided counts the heap allocations the execution context used to make per execution,
+ * the context handle and the source and target property structs, which are now built on the stack.
+ */
+struct RPG_TOPDOWN_API FTopDownCombatSimulationCounters
+{
+	static uint32 EffectExecutions;
+	static uint32 ContextResolves;
+	static uint32 ContextAllocationsAvoided;
+};
+
+#if !UE_BUILD_SHIPPING
+#define TOPDOWN_COMBAT_SIMULATION_SCOPE_EXEC_CALC() const FTopDownCombatSimulationTimer TopDownCombatSimulationTimer
+#define TOPDOWN_COMBAT_SIMULATION_COUNT(Counter, Amount) FTopDownCombatSimulationCounters::Counter += (Amount)
+
+#else
+
+#define TOPDOWN_COMBAT_SIMULATION_SCOPE_EXEC_CALC()
+#define TOPDOWN_COMBAT_SIMULATION_COUNT(Counter, Amount)
+
+#endif
+
+struct FTopDownCombatSimulationSettings
+{
+	int32 EnemyCount = 50;
+	int32 PlayerCount = 4;
+	// Simulated frames before the report is written.
+	int32 TickCount = 600;
+	// Every player casts its projectile ability once every this many frames.
+	int32 CastInterval = 10;
+	// Effect actors jump to the next enemy every this many frames, which ends one overlap and starts another.
+	int32 EffectActorInterval = 15;
+	int32 EffectActorCount = 4;
+	float Spacing = 250.f;
+	// Seconds between ticks of the Health, Mana and Stamina regen every combatant gets. 0 turns regen off.
+	float RegenPeriod = 0.f;
+	bool bQuitWhenDone = false;
+
+	FSoftClassPath EnemyClass;
+	FSoftClassPath PlayerClass;
+	FSoftClassPath EffectActorClass;
+	// Granted to players that don't already have a projectile ability.
+	FSoftClassPath ProjectileAbilityClass;
+
+	FString OutputFileName;
+};
+
+struct FTopDownCombatSimulationSample
+{
+	int32 Tick = 0;
+	// Wall clock time since the previous simulated frame.
+	double FrameTimeMs = 0.0;
+	double GameThreadTimeMs = 0.0;
+	double ExecCalcTimeMs = 0.0;
+	uint32 ExecCalcCount = 0;
+	int32 Casts = 0;
+	uint32 EffectExecutions = 0;
+	uint32 ContextResolves = 0;
+	uint32 ContextAllocationsAvoided = 0;
+	uint64 UsedPhysicalMemory = 0;
+	uint64 NetOutBytes = 0;
+};
+
+/**
+ * Dev only combat throughput benchmark. Spawns enemies and players into the current map, drives projectile casts and effect
+ * actor overlaps from script for a fixed number of frames and writes one CSV row per frame to Saved/CombatSimulation.
+ * Meant to run without rendering and with a fixed time step, so runs on the same machine are comparable:
+ *   RPG_TopDown /Game/Maps/StartupMap -game -nullrhi -unattended -benchmark -fps=30
+ *     -ExecCmds="TopDown.CombatSim.Run Enemies=100 Players=4 Ticks=1800 Quit"
+ * Add RegenPeriod=0.1 for a regen heavy run, where most PostGameplayEffectExecute calls are periodic Health, Mana and Stamina ticks.
+ * NetOutBytes only moves when running as a server with connected clients.
+ */
+UCLASS()
+class RPG_TOPDOWN_API UTopDownCombatSimulationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// Returns false if a simulation is already running or the classes could not be loaded.
+	bool StartSimulation(const FTopDownCombatSimulationSettings& InSettings);
+	void StopSimulation();
+
+	bool IsRunning() const { return bRunning; }
+
+	/* Tickable World Subsystem */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	void SpawnCombatants(UClass* EnemyClass, UClass* PlayerClass, UClass* EffectActorClass);
+	// Gives every combatant an infinite periodic effect that tops up Health, Mana and Stamina every RegenPeriod.
+	void ApplyRegen();
+	void CastProjectiles();
+	void MoveEffectActors();
+	void RecordSample();
+	void WriteReport() const;
+	void DestroyCombatants();
+
+	UTopDownProjectileAbility* FindProjectileAbility(const APlayerCharacter* PlayerCharacter) const;
+
+	FTopDownCombatSimulationSettings Settings;
+
+	UPROPERTY()
+	TArray<TObjectPtr<AEnemyCharacter>> Enemies;
+
+	UPROPERTY()
+	TArray<TObjectPtr<APlayerCharacter>> Players;
+
+	UPROPERTY()
+	TArray<TObjectPtr<AController>> PlayerControllers;
+
+	UPROPERTY()
+	TArray<TObjectPtr<ABaseEffectActor>> EffectActors;
+
+	UPROPERTY()
+	TObjectPtr<UGameplayEffect> RegenEffect;
+
+	TArray<FTopDownCombatSimulationSample> Samples;
+
+	int32 CurrentTick = 0;
+	int32 CastsThisTick = 0;
+	int32 NextTargetIndex = 0;
+	double LastTickTime = 0.0;
+	bool bRunning = false;
+};
@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AttributeSet.h"
+#include "GameplayTagContainer.h"
+#include "MassEntityTypes.h"
+#include "AbilitySystem/Data/CharacterClassInfoDataAsset.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TopDownCrowdSubsystem.generated.h"
+
+/* Forward Declaration */
+class AEnemyCharacter;
+class UAbilitySystemComponent;
+class UGameplayEffect;
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+struct FMassEntityManager;
+
+/*
+ * Crowd Fragments
+ * What a demoted enemy keeps: where it stands, what to spawn it back as, its ability system state and its instanced proxy.
+ */
+
+USTRUCT()
+struct FTopDownCrowdLocationFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	FTransform Transform;
+};
+
+USTRUCT()
+struct FTopDownCrowdClassFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSubclassOf<AEnemyCharacter> EnemyClass;
+
+	ECharacterClass CharacterClass = ECharacterClass::Warrior;
+	int32 Level = 1;
+};
+
+USTRUCT()
+struct FTopDownCrowdAbilityFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	// Key into the subsystem's ability snapshots. Unset for enemies added straight into the crowd, they keep their default attributes.
+	int32 SnapshotId = INDEX_NONE;
+};
+
+USTRUCT()
+struct FTopDownCrowdVisualFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	// Key into the subsystem's visual batches, unset when the enemy class has no proxy mesh.
+	TWeakObjectPtr<UStaticMesh> ProxyMesh;
+	int32 InstanceIndex = INDEX_NONE;
+};
+
+USTRUCT()
+struct FTopDownCrowdAttributeSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FGameplayAttribute Attribute;
+
+	float BaseValue = 0.f;
+};
+
+// An active effect, kept as what is needed to make a new spec of it rather than the spec itself.
+USTRUCT()
+struct FTopDownCrowdEffectSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSubclassOf<UGameplayEffect> EffectClass;
+
+	UPROPERTY()
+	TMap<FGameplayTag, float> SetByCallerMagnitudes;
+
+	float Level = 1.f;
+	int32 StackCount = 1;
+	// FGameplayEffectConstants::INFINITE_DURATION for infinite effects.
+	float TimeRemaining = 0.f;
+};
+
+// What a demoted enemy's ability system held, put back when it is promoted.
+USTRUCT()
+struct FTopDownCrowdAbilitySnapshot
+{
+	GENERATED_BODY()
+
+	// Base value of every attribute in the enemy's attribute sets.
+	UPROPERTY()
+	TArray<FTopDownCrowdAttributeSnapshot> AttributeBaseValues;
+
+	// Duration and infinite effects.
+	UPROPERTY()
+	TArray<FTopDownCrowdEffectSnapshot> ActiveEffects;
+};
+
+// One instanced mesh component per proxy mesh, with the entity behind each instance.
+USTRUCT()
+struct FTopDownCrowdVisualBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<UInstancedStaticMeshComponent> InstancedMesh;
+
+	TArray<FMassEntityHandle> InstanceEntities;
+};
+
+/**
+ * Crowd LOD for enemies on the server. Enemies further than TopDown.Crowd.DemoteDistance from every player are destroyed
+ * and kept as Mass entities holding only their transform, class, level and a snapshot of their ability system, drawn as one
+ * instanced static mesh per proxy mesh. Once a player comes within TopDown.Crowd.PromoteDistance the entity is spawned back
+ * as a full AEnemyCharacter. Attribute base values and duration and infinite gameplay effects (with the time they had left)
+ * are restored. Granted abilities, gameplay tags not coming from an effect, per instance edits and AI state are not, the
+ * enemy starts from its class defaults. Because of that it is opt in: TopDown.Crowd.Enabled and bCanDemoteToCrowd on the
+ * enemy both have to be set. Maps can also add enemies straight into the crowd with AddCrowdEnemy.
+ * The proxies only exist in the server's world, so they are seen in standalone and by a listen server host. Demoted
+ * enemies are far outside every player's view anyway.
+ */
+UCLASS()
+class RPG_TOPDOWN_API UTopDownCrowdSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/* Registration, server only */
+	void RegisterEnemy(AEnemyCharacter* Enemy);
+	void UnregisterEnemy(AEnemyCharacter* Enemy);
+
+	// Adds an enemy that starts out demoted. It is spawned as an actor the first time a player comes close.
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="Crowd")
+	void AddCrowdEnemy(TSubclassOf<AEnemyCharacter> EnemyClass, const FTransform& Transform, ECharacterClass CharacterClass, int32 Level);
+
+	UFUNCTION(BlueprintPure, Category="Crowd")
+	int32 GetNumCrowdEntities() const { return NumCrowdEntities; }
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	void UpdateCrowdLOD();
+	void GatherPlayerLocations();
+	bool IsNearAnyPlayer(const FVector& Location, float Distance) const;
+
+	void DemoteEnemy(AEnemyCharacter* Enemy);
+	void PromoteEntity(const FMassEntityHandle& Entity);
+
+	FMassEntityHandle CreateCrowdEntity(TSubclassOf<AEnemyCharacter> EnemyClass, const FTransform& Transform, ECharacterClass CharacterClass, int32 Level, int32 SnapshotId);
+
+	/* Ability Snapshots */
+	int32 SnapshotAbilitySystem(const UAbilitySystemComponent* AbilitySystemComponent);
+	void RestoreAbilitySystem(UAbilitySystemComponent* AbilitySystemComponent, int32 SnapshotId) const;
+	void AddInstance(const FMassEntityHandle& Entity, UStaticMesh* ProxyMesh, const FTransform& Transform);
+	void RemoveInstance(const FTopDownCrowdVisualFragment& Visual);
+
+	TSharedPtr<FMassEntityManager> EntityManager;
+	FMassArchetypeHandle CrowdArchetype;
+
+	// Enemy actors that may be demoted.
+	TArray<TWeakObjectPtr<AEnemyCharacter>> ActiveEnemies;
+
+	UPROPERTY()
+	TObjectPtr<AActor> VisualHost;
+
+	UPROPERTY()
+	TMap<TObjectPtr<UStaticMesh>, FTopDownCrowdVisualBatch> VisualBatches;
+
+	// Keyed by FTopDownCrowdAbilityFragment::SnapshotId. A property so the effect classes are seen by GC.
+	UPROPERTY()
+	TMap<int32, FTopDownCrowdAbilitySnapshot> AbilitySnapshots;
+	int32 NextSnapshotId = 0;
+
+	TArray<FVector> PlayerLocations;
+	float TimeUntilUpdate = 0.f;
+	int32 NumCrowdEntities = 0;
+};
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "TopDownHealthBarSubsystem.generated.h"
+
+/* Forward Declaration */
+class UCanvas;
+
+// How the shared health bars look, owned by the HUD.
+USTRUCT(BlueprintType)
+struct FTopDownHealthBarStyle
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category="Health Bar")
+	FVector2D Size = FVector2D(60.f, 6.f);
+
+	// Screen space offset from the projected bar position, negative is up.
+	UPROPERTY(EditAnywhere, Category="Health Bar")
+	FVector2D ScreenOffset = FVector2D(0.f, -10.f);
+
+	UPROPERTY(EditAnywhere, Category="Health Bar")
+	FLinearColor FillColor = FLinearColor(0.8f, 0.05f, 0.05f, 1.f);
+
+	UPROPERTY(EditAnywhere, Category="Health Bar")
+	FLinearColor BackgroundColor = FLinearColor(0.f, 0.f, 0.f, 0.6f);
+};
+
+/**
+ * Screen space health bars for every registered actor, drawn by the HUD in one canvas pass instead of one widget
+ * component (and one render target) per enemy. Entries live in a compact array and only hold what the draw needs.
+ * Health changes only mark the entry dirty, the fill is recomputed when the bar is next drawn, and bars that
+ * project off screen or behind the camera are skipped.
+ */
+UCLASS()
+class RPG_TOPDOWN_API UTopDownHealthBarSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Registration */
+	// HeightOffset is added to the actor location to get the bar's world position.
+	void RegisterActor(AActor* Actor, float Health, float MaxHealth, float HeightOffset);
+	void UnregisterActor(AActor* Actor);
+
+	/* Updates */
+	void SetHealth(const AActor* Actor, float Health);
+	void SetMaxHealth(const AActor* Actor, float MaxHealth);
+	// Hidden bars stay registered and keep tracking health, they are just not drawn.
+	void SetHidden(const AActor* Actor, bool bHidden);
+
+	// Called by the HUD from DrawHUD.
+	void DrawHealthBars(UCanvas* Canvas, const FTopDownHealthBarStyle& Style);
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	struct FHealthBarEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		// Still valid after the actor is gone, so stale entries can be removed from EntryIndices.
+		TObjectKey<AActor> ActorKey;
+		float Health = 0.f;
+		float MaxHealth = 0.f;
+		// Health / MaxHealth, clamped. Only recomputed while dirty.
+		float Fill = 0.f;
+		float HeightOffset = 0.f;
+		bool bDirty = true;
+		bool bHidden = false;
+	};
+
+	FHealthBarEntry* FindEntry(const AActor* Actor);
+	void RemoveEntry(int32 EntryIndex);
+
+	TArray<FHealthBarEntry> Entries;
+	TMap<TObjectKey<AActor>, int32> EntryIndices;
+};
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TopDownProjectilePoolSubsystem.generated.h"
+
+/* Forward Declaration */
+class ATopDownProjectile;
+
+USTRUCT(BlueprintType)
+struct FProjectilePoolStats
+{
+	GENERATED_BODY()
+
+	// Spawn requests served by a parked projectile.
+	UPROPERTY(BlueprintReadOnly, Category="Projectile Pool")
+	int32 Hits = 0;
+
+	// Spawn requests that had to spawn a new actor.
+	UPROPERTY(BlueprintReadOnly, Category="Projectile Pool")
+	int32 Misses = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="Projectile Pool")
+	int32 Active = 0;
+
+	// Most projectiles of the class in flight at the same time.
+	UPROPERTY(BlueprintReadOnly, Category="Projectile Pool")
+	int32 HighWaterMark = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="Projectile Pool")
+	int32 Parked = 0;
+};
+
+USTRUCT()
+struct FProjectilePool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<ATopDownProjectile>> ParkedProjectiles;
+
+	// Released projectiles past this many parked ones are destroyed.
+	int32 MaxParked = 32;
+
+	FProjectilePoolStats Stats;
+};
+
+/**
+ * Recycles projectile actors per class on the server instead of spawning and destroying one per shot.
+ * Usage mirrors SpawnActorDeferred: SpawnProjectileDeferred, set up the projectile, then FinishSpawningProjectile.
+ * Pooling can be turned off with TopDown.ProjectilePool.Enabled 0, in which case plain actors are spawned.
+ */
+UCLASS()
+class RPG_TOPDOWN_API UTopDownProjectilePoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// Spawns and parks projectiles until Count of the class are parked, so the first shots don't hitch.
+	UFUNCTION(BlueprintCallable, Category="Projectile Pool")
+	void PrewarmPool(TSubclassOf<ATopDownProjectile> ProjectileClass, int32 Count);
+
+	UFUNCTION(BlueprintCallable, Category="Projectile Pool")
+	void SetMaxPoolSize(TSubclassOf<ATopDownProjectile> ProjectileClass, int32 MaxParked);
+
+	UFUNCTION(BlueprintPure, Category="Projectile Pool")
+	FProjectilePoolStats GetPoolStats(TSubclassOf<ATopDownProjectile> ProjectileClass) const;
+
+	// Returns a parked projectile, or a newly deferred spawned one. Set DamageEffectSpecHandle before finishing it.
+	ATopDownProjectile* SpawnProjectileDeferred(TSubclassOf<ATopDownProjectile> ProjectileClass, const FTransform& SpawnTransform, AActor* Owner, APawn* Instigator);
+	void FinishSpawningProjectile(ATopDownProjectile* Projectile, const FTransform& SpawnTransform);
+
+	// Parks the projectile, or destroys it when the pool of its class is full.
+	void ReleaseProjectile(ATopDownProjectile* Projectile);
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	static bool IsPoolingEnabled();
+
+	ATopDownProjectile* SpawnPooledProjectile(TSubclassOf<ATopDownProjectile> ProjectileClass, const FTransform& SpawnTransform, AActor* Owner, APawn* Instigator) const;
+	
+	UPROPERTY()
+	TMap<TSubclassOf<ATopDownProjectile>, FProjectilePool> Pools;
+};
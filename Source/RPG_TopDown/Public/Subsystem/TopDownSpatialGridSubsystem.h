@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "TopDownSpatialGridSubsystem.generated.h"
+
+/**
+ * Uniform grid over the XY plane holding every registered character as a vertical capsule.
+ * Answers radius, cone and ray pick queries without going through the physics scene.
+ * Positions are refreshed once per frame in Tick, so results can lag a moving actor by up to a frame.
+ */
+UCLASS()
+class RPG_TOPDOWN_API UTopDownSpatialGridSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/* Registration */
+	void RegisterActor(AActor* Actor, float Radius, float HalfHeight);
+	void UnregisterActor(AActor* Actor);
+
+	/* Queries */
+	// Actors whose capsule overlaps the circle of Radius around Origin, on the XY plane.
+	UFUNCTION(BlueprintCallable, Category="Spatial Grid", meta=(DeterminesOutputType="ActorClassFilter", DynamicOutputParam="OutActors"))
+	void QueryRadius(const FVector& Origin, float Radius, TArray<AActor*>& OutActors, TSubclassOf<AActor> ActorClassFilter = nullptr) const;
+
+	// Actors within Length of Origin and within HalfAngleDegrees of Direction, on the XY plane.
+	UFUNCTION(BlueprintCallable, Category="Spatial Grid", meta=(DeterminesOutputType="ActorClassFilter", DynamicOutputParam="OutActors"))
+	void QueryCone(const FVector& Origin, const FVector& Direction, float Length, float HalfAngleDegrees, TArray<AActor*>& OutActors, TSubclassOf<AActor> ActorClassFilter = nullptr) const;
+
+	// Closest actor to RayStart whose capsule the segment passes through. Ignores world geometry.
+	UFUNCTION(BlueprintCallable, Category="Spatial Grid", meta=(DeterminesOutputType="ActorClassFilter"))
+	AActor* RayPick(const FVector& RayStart, const FVector& RayEnd, TSubclassOf<AActor> ActorClassFilter = nullptr) const;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	struct FSpatialGridEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		// Still valid after the actor is gone, so stale entries can be removed from EntryIndices.
+		TObjectKey<AActor> ActorKey;
+		FVector Location = FVector::ZeroVector;
+		FIntPoint Cell = FIntPoint::ZeroValue;
+		float Radius = 0.f;
+		float HalfHeight = 0.f;
+	};
+
+	FIntPoint GetCell(const FVector& Location) const;
+	void AddToCell(int32 EntryIndex);
+	void RemoveFromCell(int32 EntryIndex);
+	void RemoveEntry(int32 EntryIndex);
+	
+	// Calls Visitor with the index of every entry stored in the cells covering the XY box, grown by the largest registered radius.
+	template<typename FunctorType>
+	void ForEachEntryInBox(const FVector2D& Min, const FVector2D& Max, FunctorType&& Visitor) const;
+
+	TArray<FSpatialGridEntry> Entries;
+	TMap<TObjectKey<AActor>, int32> EntryIndices;
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	float CellSize = 500.f;
+	float MaxEntryRadius = 0.f;
+
+	// Vertical band covered by the registered capsules, used to clip ray picks.
+	float MinZ = TNumericLimits<float>::Max();
+	float MaxZ = TNumericLimits<float>::Lowest();
+};
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+
+/* Forward Declaration */
+class UAbilitySystemComponent;
+class UGameplayEffect;
+
+/*
+ * Combat diagnostics for Unreal Insights.
+ * Start the game with -trace=default,TopDownCombat (or "Trace.Enable TopDownCombat" at runtime) to record them.
+ * Everything below is compiled out in Shipping. With the channel off, a trace point is one branch,
+ * names and effect counts are only looked up once somebody is recording.
+ */
+#define TOPDOWN_COMBAT_TRACE_ENABLED (UE_TRACE_ENABLED && !UE_BUILD_SHIPPING)
+
+#if TOPDOWN_COMBAT_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(TopDownCombatChannel, RPG_TOPDOWN_API);
+
+struct RPG_TOPDOWN_API FTopDownCombatTrace
+{
+	static void OutputHealthChanged(const AActor* TargetActor, float Health, float MaxHealth, float Magnitude);
+	static void OutputGameplayEffectChanged(const UAbilitySystemComponent* TargetAbilitySystemComponent, TSubclassOf<UGameplayEffect> GameplayEffectClass, bool bRemoved);
+};
+
+#define TOPDOWN_TRACE_HEALTH_CHANGED(TargetActor, Health, MaxHealth, Magnitude) \
+	do \
+	{ \
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(TopDownCombatChannel)) \
+		{ \
+			FTopDownCombatTrace::OutputHealthChanged(TargetActor, Health, MaxHealth, Magnitude); \
+		} \
+	} while (0)
+
+#define TOPDOWN_TRACE_GAMEPLAY_EFFECT_CHANGED(TargetAbilitySystemComponent, GameplayEffectClass, bRemoved) \
+	do \
+	{ \
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(TopDownCombatChannel)) \
+		{ \
+			FTopDownCombatTrace::OutputGameplayEffectChanged(TargetAbilitySystemComponent, GameplayEffectClass, bRemoved); \
+		} \
+	} while (0)
+
+#else
+
+#define TOPDOWN_TRACE_HEALTH_CHANGED(TargetActor, Health, MaxHealth, Magnitude) do {} while (0)
+#define TOPDOWN_TRACE_GAMEPLAY_EFFECT_CHANGED(TargetAbilitySystemComponent, GameplayEffectClass, bRemoved) do {} while (0)
+
+#endif
@@ -24,6 +24,9 @@ public:
 	void SetIsCriticalHit(bool bInIsCriticalHit) { bIsCriticalHit = bInIsCriticalHit; }
 	// Setter for critical hit status
 	void SetIsBlockedHit(bool bInIsBlockedHit) { bIsBlockedHit = bInIsBlockedHit; }
+
+	// By default only the hit location and impact point are replicated. Opt in when the receiver needs the whole hit result.
+	void SetReplicateFullHitResult(bool bInReplicateFullHitResult) { bReplicateFullHitResult = bInReplicateFullHitResult; }
 	
 	/** Returns the actual struct used for serialization, subclasses must override this! */
 	virtual UScriptStruct* GetScriptStruct() const override
@@ -52,6 +55,15 @@ public:
 	 */
 	virtual bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess) override;
 
+	/*
+	 * Compact wire format, selected with TopDown.EffectContext.CompactNetSerialize.
+	 * The hit result goes as two quantized locations, the hit flags are packed into the header bits,
+	 * and the effect causer / actors are left out when the receiver can rebuild them from the instigator / source object.
+	 */
+	bool NetSerializeCompact(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+	// The format used before the compact one, kept for comparison.
+	bool NetSerializeLegacy(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
 protected:
 
 	// Property to store evasion status
@@ -65,6 +77,9 @@ protected:
 	// Property to store block chance status
 	UPROPERTY()
 	bool bIsBlockedHit = false;
+
+	// Only read on the sending side, see SetReplicateFullHitResult.
+	bool bReplicateFullHitResult = false;
 	
 };
 
@@ -87,6 +87,7 @@ public:
   *
   */
  FGameplayTag Damage;
+ FGameplayTag Damage_Resolved;
  FGameplayTag Effects_HitReact;
 
 private:
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/HUD.h"
+#include "Subsystem/TopDownHealthBarSubsystem.h"
 #include "TopDownHUD.generated.h"
 
 
@@ -32,6 +33,8 @@ public:
 
 	void InitializeOverlayWidget(APlayerController* PC, APlayerState* PS, UAbilitySystemComponent* ASC, UAttributeSet* AS);
 
+	virtual void DrawHUD() override;
+
 private:
 	
 	/*
@@ -69,5 +72,11 @@ private:
 	UPROPERTY(VisibleAnywhere, Category="Widget|Attribute Menu")
 	TObjectPtr<UAttributeMenuWidgetController> AttributeMenuWidgetController;
 
+	/*
+	 * Shared Health Bars
+	 */
+
+	UPROPERTY(EditAnywhere, Category="Widget|Health Bars")
+	FTopDownHealthBarStyle HealthBarStyle;
 
 };
@@ -6,8 +6,12 @@
 #include "Components/WidgetComponent.h"
 #include "DamageTextWidgetComponent.generated.h"
 
+/* Forward Declaration */
+class APlayerCharacterController;
+
 /**
- * 
+ * Floating damage number. Instances are pooled by APlayerCharacterController and reused for later hits,
+ * so Blueprint subclasses should restart their animation in SetDamageText rather than on construct.
  */
 UCLASS()
 class RPG_TOPDOWN_API UDamageTextWidgetComponent : public UWidgetComponent
@@ -18,4 +22,28 @@ public:
 
 	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
 	void SetDamageText(float Damage, bool bEvadedHit, bool bCriticalHit, bool bBlockChance);
+
+	// Makes the component visible and hands the values to SetDamageText.
+	void ShowDamageText(APlayerCharacterController* InOwningController, float Damage, bool bEvadedHit, bool bCriticalHit, bool bBlockChance);
+
+	// Hides the component and gives it back to the pool. Call this instead of DestroyComponent when the text is done.
+	UFUNCTION(BlueprintCallable, Category="Damage Text")
+	void ReleaseToPool();
+
+	// While the component is out of the pool, destroying it releases it instead, so Blueprints that destroy themselves
+	// at the end of their animation still feed the pool.
+	virtual void DestroyComponent(bool bPromoteChildren = false) override;
+
+protected:
+
+	// Seconds the number stays up before it goes back to the pool on its own, the length of the floating text animation.
+	// 0 waits for ReleaseToPool or DestroyComponent.
+	UPROPERTY(EditDefaultsOnly, Category="Damage Text", meta=(ClampMin=0.f, Units="s"))
+	float DisplayDuration = 1.f;
+
+private:
+
+	TWeakObjectPtr<APlayerCharacterController> OwningController;
+
+	FTimerHandle DisplayTimerHandle;
 };
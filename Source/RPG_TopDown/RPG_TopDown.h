@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
 /** Custom Depth Coloring */
 // 250 - Enemy
@@ -14,4 +15,12 @@
 
 // Giving alias to the custom channels
 #define ECC_Navigation ECC_GameTraceChannel1
-#define ECC_Projectile ECC_GameTraceChannel2
\ No newline at end of file
+#define ECC_Projectile ECC_GameTraceChannel2
+
+/** Cosmetics */
+// Damage numbers, projectile VFX/SFX, dissolves, health bars and the HUD. Compiled out of the dedicated server target.
+#define TOPDOWN_WITH_COSMETICS !UE_SERVER
+
+/** Stats */
+// Shows up under "stat TopDown"
+DECLARE_STATS_GROUP(TEXT("TopDown"), STATGROUP_TopDown, STATCAT_Advanced);